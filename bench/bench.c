@@ -0,0 +1,485 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+// Microbenchmarks de las primitivas del juego. Cada muestra mide un lote de operaciones y
+// da ns/op; se informan percentiles sobre las muestras, una línea por benchmark y parámetros,
+// en columnas fijas para poder comparar la salida entre commits con diff
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <ncurses.h>
+
+#include "common.h"
+#include "game.h"
+#include "shm.h"
+#include "reader_sync.h"
+#include "writer_sync.h"
+#include "neighbors.h"
+#include "board_mirror.h"
+#include "view_draw.h"
+
+#define MAX_SIZES 8
+#define DEFAULT_SAMPLES 200
+#define DEFAULT_CONTENDERS 3
+#define BENCH_PLAYERS MAX_PLAYERS
+#define MOVE_BATCH 1024         // movimientos por muestra (entran en el log de cambios)
+#define PICK_BATCH 4096
+#define SYNC_BATCH 1024
+#define MAP_SAMPLES 20          // abrir y mapear una región grande es lento: menos muestras
+#define DRAW_ROWS 60            // ventana fuera de pantalla donde dibuja la vista
+#define DRAW_COLS 240
+
+typedef struct {
+    int width, height;
+} board_size_t;
+
+// Tamaños por defecto: el último supera MAX_BOARD_SIZE a propósito
+static const board_size_t default_sizes[] = { { 100, 100 }, { 1000, 1000 }, { 12000, 3000 } };
+
+typedef struct {
+    board_size_t sizes[MAX_SIZES];
+    unsigned num_sizes;
+    unsigned samples;
+    unsigned contenders;
+    char **filters;            // prefijos de nombres de benchmark a correr (todos si no hay)
+    int num_filters;
+} bench_args_t;
+
+typedef struct {
+    double *ns;                // ns/op de cada muestra
+    unsigned count;
+} samples_t;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil por rango más cercano sobre las muestras ya ordenadas
+static double percentile(const samples_t *s, unsigned p) {
+    size_t rank = ((size_t)p * s->count + 99) / 100;
+    return s->ns[rank > 0 ? rank - 1 : 0];
+}
+
+static void report_header(void) {
+    printf("%-20s %-20s %8s %12s %12s %12s %12s\n", "benchmark", "params", "samples", "p50", "p90", "p99", "max");
+}
+
+static void report(const char *name, const char *params, samples_t *s) {
+    if (s->count == 0) {
+        printf("%-20s %-20s %8s\n", name, params, "failed");
+        return;
+    }
+    qsort(s->ns, s->count, sizeof(double), cmp_double);
+    printf("%-20s %-20s %8u %12.1f %12.1f %12.1f %12.1f\n", name, params, s->count,
+           percentile(s, 50), percentile(s, 90), percentile(s, 99), s->ns[s->count - 1]);
+    fflush(stdout);
+}
+
+static bool selected(const bench_args_t *args, const char *name) {
+    if (args->num_filters == 0)
+        return true;
+    for (int i = 0; i < args->num_filters; i++)
+        if (strncmp(name, args->filters[i], strlen(args->filters[i])) == 0)
+            return true;
+    return false;
+}
+
+static void size_params(char *buf, size_t len, board_size_t sz) {
+    snprintf(buf, len, "%dx%d", sz.width, sz.height);
+}
+
+// Partida privada (sin memoria compartida) con log de cambios, como la arma el master
+typedef struct {
+    game_t game;
+    int *pristine;             // tablero inicial, para volver a él entre muestras
+    player_t players[BENCH_PLAYERS];
+} bench_game_t;
+
+static int bench_game_init(bench_game_t *b, board_size_t sz) {
+    memset(b, 0, sizeof(*b));
+    size_t cells = (size_t)sz.width * sz.height;
+    b->game.state = malloc(game_state_size(sz.width, sz.height, BOARD_FORMAT_INT));
+    b->game.deltas = calloc(1, delta_log_size(DELTA_LOG_CAPACITY));
+    b->pristine = malloc(cells * sizeof(int));
+    if (!b->game.state || !b->game.deltas || !b->pristine)
+        return -1;
+    b->game.format = BOARD_FORMAT_INT;
+    b->game.deltas->capacity = DELTA_LOG_CAPACITY;
+    game_state_t *gs = b->game.state;
+    memset(gs, 0, sizeof(*gs));
+    gs->board_width = (unsigned short)sz.width;
+    gs->board_height = (unsigned short)sz.height;
+    gs->num_players = BENCH_PLAYERS;
+    init_board(&b->game, 1, BOARD_GEN_COUNTER);
+    place_players(&b->game);
+    memcpy(b->pristine, gs->board, cells * sizeof(int));
+    memcpy(b->players, gs->players, sizeof(b->players));
+    return 0;
+}
+
+static void bench_game_free(bench_game_t *b) {
+    free(b->game.state);
+    free(b->game.deltas);
+    free(b->pristine);
+}
+
+// Deshace los cambios publicados desde head: solo se tocan las celdas capturadas
+static void bench_game_reset(bench_game_t *b, unsigned long long head) {
+    delta_log_t *log = b->game.deltas;
+    for (unsigned long long k = head; k < log->head; k++) {
+        unsigned cell = log->entries[k & (log->capacity - 1)].cell;
+        b->game.state->board[cell] = b->pristine[cell];
+    }
+    memcpy(b->game.state->players, b->players, sizeof(b->players));
+}
+
+// Cada muestra parte del mismo tablero: los jugadores caminan en direcciones al azar desde
+// su posición inicial, con una mezcla de movimientos válidos e inválidos como en una partida
+static void bench_apply_move(const bench_args_t *args, board_size_t sz, unsigned char *dirs) {
+    char params[32];
+    size_params(params, sizeof(params), sz);
+    samples_t s = { malloc(args->samples * sizeof(double)), 0 };
+    bench_game_t b = { 0 };
+    if (s.ns && bench_game_init(&b, sz) == 0) {
+        for (unsigned i = 0; i < args->samples; i++) {
+            const unsigned char *d = dirs + (size_t)i * MOVE_BATCH;
+            unsigned long long head = b.game.deltas->head;
+            double t0 = now_ns();
+            for (int k = 0; k < MOVE_BATCH; k++)
+                apply_move(&b.game, k % BENCH_PLAYERS, d[k]);
+            s.ns[s.count++] = (now_ns() - t0) / MOVE_BATCH;
+            bench_game_reset(&b, head);
+        }
+    }
+    report("apply_move", params, &s);
+    bench_game_free(&b);
+    free(s.ns);
+}
+
+// Tablero con un 30% de celdas capturadas y posiciones al azar en todo el tablero
+static void bench_pick_dir(const bench_args_t *args, board_size_t sz) {
+    char params[32];
+    size_params(params, sizeof(params), sz);
+    size_t cells = (size_t)sz.width * sz.height;
+    samples_t s = { malloc(args->samples * sizeof(double)), 0 };
+    int *board = malloc(cells * sizeof(int));
+    int *pos = malloc(PICK_BATCH * 2 * sizeof(int));
+    if (s.ns && board && pos) {
+        unsigned seed = 1;
+        for (size_t i = 0; i < cells; i++)
+            board[i] = rand_r(&seed) % 10 < 3 ? -(rand_r(&seed) % BENCH_PLAYERS) : MIN_REWARD + rand_r(&seed) % MAX_REWARD;
+        long sink = 0;
+        for (unsigned i = 0; i < args->samples; i++) {
+            for (int k = 0; k < PICK_BATCH; k++) {
+                pos[2 * k] = rand_r(&seed) % sz.width;
+                pos[2 * k + 1] = rand_r(&seed) % sz.height;
+            }
+            double t0 = now_ns();
+            for (int k = 0; k < PICK_BATCH; k++)
+                sink += pick_dir(board, sz.width, sz.height, pos[2 * k], pos[2 * k + 1]);
+            s.ns[s.count++] = (now_ns() - t0) / PICK_BATCH;
+        }
+        if (sink == -1) // para que el compilador no descarte las llamadas
+            putchar(' ');
+    }
+    report("pick_dir", params, &s);
+    free(board);
+    free(pos);
+    free(s.ns);
+}
+
+// Crear la región, fijarle el tamaño y mapearla es lo que hace el master al arrancar cada partida
+static void bench_shm_map(const bench_args_t *args, board_size_t sz, const char *name, unsigned opts) {
+    char params[32], region[64];
+    snprintf(params, sizeof(params), "%dx%d%s", sz.width, sz.height, opts & SHM_MAP_PREFAULT ? " prefault" : "");
+    snprintf(region, sizeof(region), "/chomp_bench_%d_state", (int)getpid());
+    unsigned n = args->samples < MAP_SAMPLES ? args->samples : MAP_SAMPLES;
+    samples_t s = { malloc(n * sizeof(double)), 0 };
+    for (unsigned i = 0; s.ns && i < n; i++) {
+        shm_adt h;
+        game_state_t *gs;
+        double t0 = now_ns();
+        if (shm_region_open(&h, region, game_state_size(sz.width, sz.height, BOARD_FORMAT_INT)) == -1)
+            break;
+        int r = game_state_map(h, (unsigned short)sz.width, (unsigned short)sz.height, BOARD_FORMAT_INT, opts, &gs);
+        double t = now_ns() - t0;
+        game_state_unmap_destroy(h);
+        if (r == -1)
+            break;
+        s.ns[s.count++] = t;
+    }
+    report(name, params, &s);
+    free(s.ns);
+}
+
+typedef enum {
+    SYNC_READER,
+    SYNC_WRITER,
+    SYNC_SEQLOCK
+} sync_op_t;
+
+static const char *sync_names[] = { "reader_enter/exit", "writer_enter/exit", "seq_read" };
+
+static void sync_pair(game_sync_t *sync, sync_op_t op) {
+    switch (op) {
+    case SYNC_READER:
+        reader_enter(sync);
+        reader_exit(sync);
+        break;
+    case SYNC_WRITER:
+        writer_enter(sync);
+        writer_exit(sync);
+        break;
+    case SYNC_SEQLOCK: {
+        unsigned t;
+        do {
+            t = seq_read_begin(sync);
+        } while (!seq_read_valid(sync, t));
+        break;
+    }
+    }
+}
+
+// Los procesos que compiten hacen de jugadores: leen con reader_enter/reader_exit sin parar
+static void contend(game_sync_t *sync, volatile int *stop) {
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    while (!*stop)
+        sync_pair(sync, SYNC_READER);
+    _exit(0);
+}
+
+static void bench_sync(const bench_args_t *args, game_sync_t *sync, unsigned contenders) {
+    char params[32];
+    snprintf(params, sizeof(params), "contenders=%u", contenders);
+    volatile int *stop = mmap(NULL, sizeof(int), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (stop == MAP_FAILED)
+        return;
+    *stop = 0;
+    pid_t pids[contenders > 0 ? contenders : 1];
+    unsigned started = 0;
+    for (; started < contenders; started++) {
+        pid_t pid = fork();
+        if (pid == -1)
+            break;
+        if (pid == 0)
+            contend(sync, stop);
+        pids[started] = pid;
+    }
+    for (sync_op_t op = SYNC_READER; op <= SYNC_SEQLOCK; op++) {
+        if (!selected(args, sync_names[op]))
+            continue;
+        samples_t s = { malloc(args->samples * sizeof(double)), 0 };
+        for (unsigned i = 0; s.ns && started == contenders && i < args->samples; i++) {
+            double t0 = now_ns();
+            for (int k = 0; k < SYNC_BATCH; k++)
+                sync_pair(sync, op);
+            s.ns[s.count++] = (now_ns() - t0) / SYNC_BATCH;
+        }
+        report(sync_names[op], params, &s);
+        free(s.ns);
+    }
+    *stop = 1;
+    for (unsigned i = 0; i < started; i++)
+        waitpid(pids[i], NULL, 0);
+    munmap((void *)stop, sizeof(int));
+}
+
+// La vista dibuja en un pad que nunca se manda a la terminal: se mide armar el cuadro, no la salida
+typedef struct {
+    SCREEN *screen;
+    FILE *out, *in;
+    WINDOW *pad;
+} offscreen_t;
+
+static int offscreen_init(offscreen_t *o) {
+    memset(o, 0, sizeof(*o));
+    if (getenv("TERM") == NULL)
+        setenv("TERM", "xterm-256color", 1);
+    o->out = fopen("/dev/null", "w");
+    o->in = fopen("/dev/null", "r");
+    if (!o->out || !o->in || !(o->screen = newterm(NULL, o->out, o->in)))
+        return -1;
+    if (has_colors())
+        start_color();
+    o->pad = newpad(DRAW_ROWS, DRAW_COLS);
+    return o->pad ? 0 : -1;
+}
+
+static void offscreen_end(offscreen_t *o) {
+    if (o->pad)
+        delwin(o->pad);
+    if (o->screen) {
+        endwin();
+        delscreen(o->screen);
+    }
+    if (o->out)
+        fclose(o->out);
+    if (o->in)
+        fclose(o->in);
+}
+
+// draw_full: primer cuadro (ubicar el tablero y dibujar todas las celdas visibles).
+// draw_diff: un cuadro por ronda de movimientos, con la copia del tablero al día por el log
+static void bench_draw(const bench_args_t *args, board_size_t sz, offscreen_t *o, const unsigned char *dirs) {
+    char params[32];
+    size_params(params, sizeof(params), sz);
+    samples_t full = { malloc(args->samples * sizeof(double)), 0 };
+    samples_t diff = { malloc(args->samples * sizeof(double)), 0 };
+    bench_game_t b = { 0 };
+    board_mirror_t mirror;
+    frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.win = o->pad;
+    bool ok = full.ns && diff.ns && bench_game_init(&b, sz) == 0 &&
+              board_mirror_init(&mirror, sz.width, sz.height, BOARD_FORMAT_INT, b.game.deltas) == 0;
+    if (ok) {
+        board_mirror_read(&mirror, b.game.state);
+        board_mirror_commit(&mirror);
+        for (unsigned i = 0; i < args->samples; i++) {
+            bool redraw = false;
+            frame_free(&frame);
+            double t0 = now_ns();
+            if (frame_layout(&frame, sz.width, sz.height, BENCH_PLAYERS, 1, &redraw)) {
+                frame_index_players(&frame, b.game.state, NULL);
+                draw_board_diff(&frame, &mirror, sz.width, true);
+                full.ns[full.count++] = now_ns() - t0;
+            }
+        }
+        for (unsigned i = 0; frame.drawn && i < args->samples; i++) {
+            for (int k = 0; k < BENCH_PLAYERS; k++)
+                apply_move(&b.game, k, dirs[(size_t)i * BENCH_PLAYERS + k]);
+            board_mirror_read(&mirror, b.game.state);
+            board_mirror_commit(&mirror);
+            double t0 = now_ns();
+            frame_index_players(&frame, b.game.state, NULL);
+            draw_board_diff(&frame, &mirror, sz.width, false);
+            diff.ns[diff.count++] = now_ns() - t0;
+        }
+        board_mirror_free(&mirror);
+    }
+    report("draw_full", params, &full);
+    report("draw_diff", params, &diff);
+    frame_free(&frame);
+    bench_game_free(&b);
+    free(full.ns);
+    free(diff.ns);
+}
+
+static int parse_size(const char *s, board_size_t *out) {
+    int w, h;
+    char x;
+    if (sscanf(s, "%d%c%d", &w, &x, &h) != 3 || x != 'x' || w < 1 || h < 1 || w > 65535 || h > 65535)
+        return -1;
+    out->width = w;
+    out->height = h;
+    return 0;
+}
+
+static int parse_args(int argc, char **argv, bench_args_t *args) {
+    memset(args, 0, sizeof(*args));
+    args->samples = DEFAULT_SAMPLES;
+    args->contenders = DEFAULT_CONTENDERS;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:n:c:")) != -1) {
+        switch (opt) {
+        case 's':
+            if (args->num_sizes == MAX_SIZES || parse_size(optarg, &args->sizes[args->num_sizes]) == -1)
+                return -1;
+            args->num_sizes++;
+            break;
+        case 'n':
+            args->samples = (unsigned)atoi(optarg);
+            if (args->samples == 0)
+                return -1;
+            break;
+        case 'c':
+            args->contenders = (unsigned)atoi(optarg);
+            break;
+        default:
+            return -1;
+        }
+    }
+    if (args->num_sizes == 0) {
+        args->num_sizes = sizeof(default_sizes) / sizeof(default_sizes[0]);
+        memcpy(args->sizes, default_sizes, sizeof(default_sizes));
+    }
+    args->filters = argv + optind;
+    args->num_filters = argc - optind;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    bench_args_t args;
+    if (parse_args(argc, argv, &args) == -1) {
+        fprintf(stderr, "uso: %s [-s WxH]... [-n samples] [-c contenders] [benchmark...]\n", argv[0]);
+        return 1;
+    }
+    size_t ndirs = (size_t)args.samples * MOVE_BATCH;
+    unsigned char *dirs = malloc(ndirs);
+    if (!dirs) {
+        perror("bench");
+        return 1;
+    }
+    unsigned seed = 1;
+    for (size_t i = 0; i < ndirs; i++)
+        dirs[i] = (unsigned char)(rand_r(&seed) % NUM_DIRECTIONS);
+
+    report_header();
+    for (unsigned i = 0; i < args.num_sizes; i++)
+        if (selected(&args, "apply_move"))
+            bench_apply_move(&args, args.sizes[i], dirs);
+    for (unsigned i = 0; i < args.num_sizes; i++)
+        if (selected(&args, "pick_dir"))
+            bench_pick_dir(&args, args.sizes[i]);
+
+    if (selected(&args, "reader_enter/exit") || selected(&args, "writer_enter/exit") || selected(&args, "seq_read")) {
+        char name[64];
+        snprintf(name, sizeof(name), "/chomp_bench_%d_sync", (int)getpid());
+        shm_adt h;
+        game_sync_t *sync;
+        if (shm_region_open(&h, name, sizeof(game_sync_t)) == -1 || game_sync_map(h, &sync) == -1) {
+            perror("sync region");
+        } else {
+            bench_sync(&args, sync, 0);
+            if (args.contenders > 0)
+                bench_sync(&args, sync, args.contenders);
+            game_sync_unmap_destroy(h);
+        }
+    }
+
+    for (unsigned i = 0; i < args.num_sizes; i++) {
+        if (!selected(&args, "shm_open+map"))
+            break;
+        bench_shm_map(&args, args.sizes[i], "shm_open+map", 0);
+        bench_shm_map(&args, args.sizes[i], "shm_open+map", SHM_MAP_PREFAULT);
+    }
+
+    if (selected(&args, "draw_full") || selected(&args, "draw_diff")) {
+        offscreen_t o;
+        if (offscreen_init(&o) == -1)
+            fprintf(stderr, "bench: no se pudo abrir una terminal fuera de pantalla\n");
+        else
+            for (unsigned i = 0; i < args.num_sizes; i++)
+                bench_draw(&args, args.sizes[i], &o, dirs);
+        offscreen_end(&o);
+    }
+
+    free(dirs);
+    return 0;
+}
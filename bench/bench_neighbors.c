@@ -0,0 +1,111 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+// Microbenchmark del kernel de vecindario: mapa de todo el tablero y elección de dirección
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+#include "neighbors.h"
+
+#define MAP_ROUNDS 20
+#define PICKS 2000000
+#define PICK_SIDE 256   // las elecciones de dirección van sobre un tablero que entra en caché
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// pick_dir de antes: get_direction_offset e is_inside por dirección
+static int pick_dir_helpers(const int board[], int width, int height, int x, int y) {
+    int max_score = 0;
+    int dir = -1;
+    for (direction_t d = 0; d < NUM_DIRECTIONS; d++) {
+        int dx, dy;
+        get_direction_offset(d, &dx, &dy);
+        if (is_inside(x + dx, y + dy, width, height)) {
+            int current_score = board[idx(x + dx, y + dy, width)];
+            if (current_score > max_score) {
+                max_score = current_score;
+                dir = d;
+            }
+        }
+    }
+    return dir;
+}
+
+int main(int argc, char **argv) {
+    int width = argc > 1 ? atoi(argv[1]) : 2000;
+    int height = argc > 2 ? atoi(argv[2]) : 2000;
+    size_t cells = (size_t)width * height;
+    int *board = malloc(cells * sizeof(int));
+    uint8_t *best = malloc(cells), *count = malloc(cells);
+    uint8_t *ref_best = malloc(cells), *ref_count = malloc(cells);
+    int *xs = malloc(PICKS * sizeof(int)), *ys = malloc(PICKS * sizeof(int));
+    if (!board || !best || !count || !ref_best || !ref_count || !xs || !ys) {
+        perror("bench_neighbors");
+        return 1;
+    }
+    srand(1);
+    for (size_t i = 0; i < cells; i++)
+        board[i] = rand() % 10 < 3 ? -(rand() % 9) : MIN_REWARD + rand() % MAX_REWARD;
+    int pw = width < PICK_SIDE ? width : PICK_SIDE, ph = height < PICK_SIDE ? height : PICK_SIDE;
+    for (int i = 0; i < PICKS; i++) {
+        xs[i] = rand() % pw;
+        ys[i] = rand() % ph;
+    }
+
+    printf("board %dx%d\n", width, height);
+    neighbors_map(NEIGHBORS_SCALAR, board, width, height, ref_best, ref_count);
+    for (neighbors_impl_t impl = 0; impl < NEIGHBORS_IMPLS; impl++) {
+        if (!neighbors_impl_supported(impl)) {
+            printf("%-24s %-8s unsupported\n", "neighbors_map", neighbors_impl_name(impl));
+            continue;
+        }
+        double min_ns = 0;
+        for (int r = 0; r < MAP_ROUNDS; r++) {
+            double t0 = now_ns();
+            neighbors_map(impl, board, width, height, best, count);
+            double t = now_ns() - t0;
+            if (r == 0 || t < min_ns)
+                min_ns = t;
+        }
+        bool same = !memcmp(best, ref_best, cells) && !memcmp(count, ref_count, cells);
+        printf("%-24s %-8s %8.3f cells/ns%s\n", "neighbors_map", neighbors_impl_name(impl),
+               (double)cells / min_ns, same ? "" : "  MISMATCH");
+    }
+
+    printf("pick board %dx%d\n", pw, ph);
+    long sink = 0;
+    double t0 = now_ns();
+    for (int i = 0; i < PICKS; i++)
+        sink += pick_dir_helpers(board, pw, ph, xs[i], ys[i]);
+    double base_ns = (now_ns() - t0) / PICKS;
+    printf("%-24s %-8s %8.2f ns/op\n", "pick_dir", "helpers", base_ns);
+    for (neighbors_impl_t impl = 0; impl < NEIGHBORS_IMPLS; impl++) {
+        if (!neighbors_impl_supported(impl))
+            continue;
+        long check = 0;
+        t0 = now_ns();
+        for (int i = 0; i < PICKS; i++)
+            check += neighbors_best_dir(impl, board, pw, ph, xs[i], ys[i], NULL);
+        double ns = (now_ns() - t0) / PICKS;
+        printf("%-24s %-8s %8.2f ns/op%s\n", "neighbors_best_dir", neighbors_impl_name(impl), ns,
+               check == sink ? "" : "  MISMATCH");
+    }
+
+    free(board);
+    free(best);
+    free(count);
+    free(ref_best);
+    free(ref_count);
+    free(xs);
+    free(ys);
+    return 0;
+}
@@ -0,0 +1,271 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+// Componentes de libres de reach.c: capturas al azar, comparadas después de cada una contra
+// reach_init sobre el tablero actual, y lo que cuesta cada captura contra etiquetar de nuevo.
+// También juega partidas con pick_dir para ver que -e no cambia los puntajes finales
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+#include "game.h"
+#include "neighbors.h"
+#include "reach.h"
+
+#define SEEDS 4
+#define WALK_PERCENT 70   // capturas que siguen a la anterior, como un jugador; el resto son al azar
+
+typedef struct {
+    int width, height;
+} board_size_t;
+
+// Incluye tableros de una fila o columna, donde casi toda captura parte su componente
+static const board_size_t sizes[] = { { 10, 10 }, { 48, 48 }, { 120, 30 }, { 1, 300 }, { 300, 2 } };
+
+// Partidas completas: un jugador solo (el caso más fácil de cortar de más) y varios que se encierran
+static const board_size_t game_sizes[] = { { 10, 10 }, { 20, 15 }, { 48, 48 }, { 120, 30 } };
+static const unsigned game_players[] = { 1, 2, 4, 9 };
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Mismas componentes (salvo los números), mismos tamaños y recompensas, y ninguna componente viva
+// de más. fwd y back tienen un lugar por componente de cada lado
+static bool same_components(const reach_t *got, const reach_t *want, uint32_t *fwd, uint32_t *back) {
+    size_t cells = (size_t)want->width * want->height;
+    memset(fwd, 0, want->num_comps * sizeof(uint32_t));
+    memset(back, 0, got->num_comps * sizeof(uint32_t));
+    for (size_t i = 0; i < cells; i++) {
+        uint32_t w = want->label[i], g = got->label[i];
+        if (!w || !g) {
+            if (w != g)
+                return false;
+            continue;
+        }
+        if (!fwd[w] && !back[g]) {
+            fwd[w] = g;
+            back[g] = w;
+        } else if (fwd[w] != g || back[g] != w) {
+            return false;
+        }
+    }
+    uint32_t alive = 0;
+    for (uint32_t c = 1; c < got->num_comps; c++)
+        alive += got->comps[c].size > 0;
+    if (alive != want->num_comps - 1)
+        return false;
+    for (uint32_t w = 1; w < want->num_comps; w++) {
+        const reach_comp_t *a = &want->comps[w], *b = &got->comps[fwd[w]];
+        if (a->size != b->size || a->reward != b->reward)
+            return false;
+    }
+    return true;
+}
+
+// Próxima celda a capturar: una vecina libre de la anterior o, si no hay, una libre al azar
+static int next_capture(const game_t *g, int last, const int *free_cells, size_t num_free) {
+    int W = g->state->board_width, H = g->state->board_height;
+    if (last >= 0 && rand() % 100 < WALK_PERCENT) {
+        int x = last % W, y = last / W;
+        direction_t start = (direction_t)(rand() % NUM_DIRECTIONS);
+        for (direction_t k = 0; k < NUM_DIRECTIONS; k++) {
+            int dx, dy;
+            get_direction_offset((direction_t)((start + k) % NUM_DIRECTIONS), &dx, &dy);
+            if (is_inside(x + dx, y + dy, W, H) && cell_is_free(g->state->board[idx(x + dx, y + dy, W)]))
+                return idx(x + dx, y + dy, W);
+        }
+    }
+    return free_cells[rand() % num_free];
+}
+
+// Captura todo el tablero de a una celda; devuelve las capturas hechas o -1 si algo no coincide
+static long run_board(int W, int H, unsigned seed, double *capture_ns, double *relabel_ns) {
+    size_t cells = (size_t)W * H;
+    game_t game = { .format = BOARD_FORMAT_INT };
+    game.state = calloc(1, game_state_size(W, H, BOARD_FORMAT_INT));
+    int *free_cells = malloc(cells * sizeof(int));
+    size_t *pos = malloc(cells * sizeof(size_t));
+    uint32_t *fwd = malloc((cells + 1) * sizeof(uint32_t)), *back = malloc((cells + 1) * sizeof(uint32_t));
+    reach_t inc = { 0 }, ref;
+    long captures = 0;
+    if (!game.state || !free_cells || !pos || !fwd || !back) {
+        perror("bench_reach");
+        captures = -1;
+        goto out;
+    }
+    game.state->board_width = (unsigned short)W;
+    game.state->board_height = (unsigned short)H;
+    game.state->num_players = 1;
+    init_board(&game, seed, BOARD_GEN_RAND);
+    size_t num_free = 0;
+    for (size_t i = 0; i < cells; i++) {
+        if (!cell_is_free(game.state->board[i]))
+            continue;
+        pos[i] = num_free;
+        free_cells[num_free++] = (int)i;
+    }
+    if (reach_init(&inc, &game) == -1) {
+        perror("bench_reach");
+        captures = -1;
+        goto out;
+    }
+
+    int last = -1;
+    while (num_free > 0) {
+        int cell = next_capture(&game, last, free_cells, num_free);
+        unsigned reward = (unsigned)game.state->board[cell];
+        game.state->board[cell] = player_to_cell_value(0);
+        size_t p = pos[cell];
+        free_cells[p] = free_cells[--num_free];
+        pos[free_cells[p]] = p;
+        last = cell;
+
+        double t0 = now_ns();
+        reach_capture(&inc, &game, cell, reward);
+        double t1 = now_ns();
+        if (reach_init(&ref, &game) == -1) {
+            perror("bench_reach");
+            captures = -1;
+            break;
+        }
+        double t2 = now_ns();
+        *capture_ns += t1 - t0;
+        *relabel_ns += t2 - t1;
+        captures++;
+        bool same = same_components(&inc, &ref, fwd, back);
+        reach_free(&ref);
+        if (!same) {
+            fprintf(stderr, "bench_reach: %dx%d seed %u: components differ after capturing %d (capture %ld)\n",
+                    W, H, seed, cell, captures);
+            captures = -1;
+            break;
+        }
+    }
+out:
+    reach_free(&inc);
+    free(game.state);
+    free(free_cells);
+    free(pos);
+    free(fwd);
+    free(back);
+    return captures;
+}
+
+// Juega una partida en la que cada jugador elige con pick_dir, en rondas como las del master,
+// hasta que todos quedan bloqueados. Los puntajes de la primera ronda después de la cual
+// reach_decided da true (lo que dejaría -e) tienen que ser los del final. 1 si coinciden, 0 si no,
+// -1 si no hay memoria
+static int run_game(int W, int H, unsigned seed, unsigned players, long *rounds_saved) {
+    game_t game = { .format = BOARD_FORMAT_INT };
+    game.state = calloc(1, game_state_size(W, H, BOARD_FORMAT_INT));
+    reach_t reach = { 0 };
+    int rc = -1;
+    if (!game.state)
+        goto out;
+    game_state_t *gs = game.state;
+    gs->board_width = (unsigned short)W;
+    gs->board_height = (unsigned short)H;
+    gs->num_players = players;
+    init_board(&game, seed, BOARD_GEN_RAND);
+    place_players(&game);
+    if (game_track_neighbors(&game) == -1 || reach_init(&reach, &game) == -1)
+        goto out;
+
+    unsigned early[MAX_PLAYERS];
+    long decided_at = -1, round = 0;
+    while (game.num_blocked < players) {
+        bool changed = false;
+        for (unsigned i = 0; i < players; i++) {
+            player_t *p = &gs->players[i];
+            if (p->is_blocked)
+                continue;
+            int dir = pick_dir(gs->board, W, H, p->x, p->y);
+            if (dir < 0) {
+                block_player(&game, i);
+                changed = true;
+                continue;
+            }
+            unsigned score_before = p->score;
+            if (apply_move(&game, (int)i, (unsigned char)dir)) {
+                reach_capture(&reach, &game, idx(p->x, p->y, W), p->score - score_before);
+                changed = true;
+            }
+        }
+        round++;
+        if (decided_at < 0 && changed && reach_decided(&reach, &game)) {
+            decided_at = round;
+            for (unsigned i = 0; i < players; i++)
+                early[i] = gs->players[i].score;
+        }
+    }
+
+    rc = decided_at >= 0;
+    for (unsigned i = 0; i < players && rc; i++) {
+        if (early[i] != gs->players[i].score) {
+            fprintf(stderr, "bench_reach: %dx%d seed %u, %u players: player %u has %u with -e and %u without\n",
+                    W, H, seed, players, i, early[i], gs->players[i].score);
+            rc = 0;
+        }
+    }
+    if (decided_at < 0)
+        fprintf(stderr, "bench_reach: %dx%d seed %u, %u players: reach_decided never held\n", W, H, seed, players);
+    else
+        *rounds_saved += round - decided_at;
+out:
+    if (rc == -1)
+        perror("bench_reach");
+    reach_free(&reach);
+    game_untrack_neighbors(&game);
+    free(game.state);
+    return rc;
+}
+
+int main(void) {
+    int rc = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int W = sizes[s].width, H = sizes[s].height;
+        double capture_ns = 0, relabel_ns = 0;
+        long total = 0;
+        bool same = true;
+        for (unsigned seed = 1; seed <= SEEDS && same; seed++) {
+            srand(seed);
+            long n = run_board(W, H, seed, &capture_ns, &relabel_ns);
+            if (n < 0)
+                same = false;
+            else
+                total += n;
+        }
+        if (!same)
+            rc = 1;
+        char name[32];
+        snprintf(name, sizeof name, "%dx%d", W, H);
+        printf("%-24s %-10s %10.1f ns/capture  relabel %10.1f ns%s\n", "reach_capture", name,
+               total ? capture_ns / (double)total : 0.0, total ? relabel_ns / (double)total : 0.0,
+               same ? "" : "  MISMATCH");
+    }
+
+    for (size_t s = 0; s < sizeof(game_sizes) / sizeof(game_sizes[0]); s++) {
+        int W = game_sizes[s].width, H = game_sizes[s].height;
+        long games = 0, rounds_saved = 0;
+        bool same = true;
+        for (size_t p = 0; p < sizeof(game_players) / sizeof(game_players[0]) && same; p++)
+            for (unsigned seed = 1; seed <= SEEDS && same; seed++) {
+                same = run_game(W, H, seed, game_players[p], &rounds_saved) == 1;
+                games++;
+            }
+        if (!same)
+            rc = 1;
+        char name[32];
+        snprintf(name, sizeof name, "%dx%d", W, H);
+        printf("%-24s %-10s %10ld games     %10ld rounds after -e%s\n", "reach_decided", name, games,
+               rounds_saved, same ? "" : "  MISMATCH");
+    }
+    return rc;
+}
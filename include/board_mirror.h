@@ -0,0 +1,32 @@
+#ifndef BOARD_MIRROR_H
+#define BOARD_MIRROR_H
+
+#pragma once
+#include "common.h"
+
+// Copia privada del tablero que se mantiene al día con el log de cambios del master.
+// Si no hay log, o si el lector quedó más atrás que la capacidad del log, se copia el tablero entero.
+typedef struct {
+    int width, height;
+    board_format_t format;         // formato del tablero en memoria compartida
+    int *board;                    // copia privada del tablero
+    const delta_log_t *log;        // log en memoria compartida, NULL si no hay
+    unsigned long long seq;        // cantidad de cambios del log ya aplicados
+    bool synced;                   // false hasta completar una copia entera
+    bool pending_full;             // el último snapshot fue una copia entera
+    unsigned long long pending_head;
+    size_t pending_count;
+    board_delta_t *pending;        // cambios leídos en el último snapshot
+    unsigned long full_syncs;      // copias enteras realizadas
+    unsigned long delta_syncs;     // actualizaciones incrementales realizadas
+} board_mirror_t;
+
+int board_mirror_init(board_mirror_t *m, int width, int height, board_format_t format, const delta_log_t *log);
+void board_mirror_free(board_mirror_t *m);
+
+// Se llama dentro de snapshot_begin/snapshot_end (puede repetirse si el snapshot no es válido)
+void board_mirror_read(board_mirror_t *m, const game_state_t *gs);
+// Se llama una vez que el snapshot fue válido
+void board_mirror_commit(board_mirror_t *m);
+
+#endif
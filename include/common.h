@@ -2,6 +2,8 @@
 #define COMMON_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <semaphore.h>
 
@@ -10,16 +12,31 @@
 // Nombres de las memorias compartidas
 #define SHM_STATE "/game_state"
 #define SHM_SYNC "/game_sync"
+#define SHM_MOVES "/game_moves"
+
+// Variables de entorno con las que el master pasa otros nombres de memoria a sus hijos
+#define ENV_SHM_STATE "CHOMP_SHM_STATE"
+#define ENV_SHM_SYNC "CHOMP_SHM_SYNC"
+#define ENV_SHM_MOVES "CHOMP_SHM_MOVES"
+
+// Jugadores del pool (match.h): se lanzan con CHOMP_POOL=1 y sin argumentos, leen por stdin una
+// línea por partida ("<W> <H> <estado> <sync> <movimientos> <estadísticas>") y cuando sueltan
+// las regiones de la partida mandan POOL_GAME_DONE por stdout
+#define ENV_PLAYER_POOL "CHOMP_POOL"
+#define POOL_GAME_DONE 0xFF
+#define POOL_LINE_MAX 512
 
 // Valores por defecto de tiempo
 #define DEFAULT_DELAY_MS 200
 #define DEFAULT_TIMEOUT_S 10
 
 // Dimensiones y límites del juego
-#define MAX_PLAYERS 9
+#define MAX_PLAYERS 9              // jugadores en game_state_t::players (formato de la cátedra)
+#define MAX_PLAYERS_EXT 1024       // con las extensiones, del décimo en adelante van en tablas aparte
+#define MAX_COMPACT_PLAYERS 129    // en el formato compacto el dueño (0..-128) tiene que entrar en un int8_t
 #define MAX_NAME_LEN 16
 #define MIN_BOARD_SIZE 10
-#define MAX_BOARD_SIZE 100
+#define MAX_BOARD_SIZE 10000
 
 // Valores del tablero
 #define MIN_REWARD 1
@@ -78,9 +95,40 @@ typedef struct {
     sem_t reader_count_mutex;        // E: Mutex para la variable reader_count (para protegerla)
     unsigned int reader_count;       // F: Cantidad de jugadores leyendo el estado en el instánte actual
     sem_t player_ready[MAX_PLAYERS]; // G: Indica a cada jugador que puede enviar 1 movimiento. Garantiza 1 movimiento por vez por jugador
-    // 
+    // Extensiones: solo existen en regiones creadas por este master (el de la cátedra termina en G)
+    unsigned int ext_magic;          // GAME_SYNC_MAGIC si la región trae las extensiones
+    unsigned int read_protocol;      // Protocolo que deben usar los lectores (read_protocol_t)
+    unsigned int seq;                // H: Contador de secuencia, impar mientras el master escribe
+    unsigned int features;           // Estructuras extra presentes en la región de estado (GAME_FEATURE_*)
+    unsigned int state_map_opts;     // Opciones SHM_MAP_* con las que conviene mapear el estado
+    unsigned int board_format;       // Formato de las celdas del tablero (board_format_t)
+    unsigned int move_transport;     // Cómo mandan los jugadores sus movimientos (move_transport_t)
+    unsigned int view_fps;           // 0: la vista dibuja cada cambio con view_ready/view_done; si no, cuadros por segundo máximos
+    unsigned int view_generation;    // con view_fps > 0, el master lo incrementa en cada cambio que antes le avisaba a la vista
 } game_sync_t;
 
+#define GAME_SYNC_MAGIC 0x43484d50u // "CHMP"
+#define GAME_SYNC_LEGACY_SIZE offsetof(game_sync_t, ext_magic)
+
+#define GAME_FEATURE_DELTA_LOG 0x1u  // log de cambios del tablero después del tablero
+
+// Formato del tablero en la región de estado. BOARD_FORMAT_INT es el de la cátedra;
+// BOARD_FORMAT_COMPACT guarda cada celda en un int8_t seguido de un bitmap de celdas libres
+typedef enum {
+    BOARD_FORMAT_INT = 0,
+    BOARD_FORMAT_COMPACT = 1
+} board_format_t;
+
+typedef enum {
+    READ_PROTOCOL_RW = 0,        // lectores/escritor con semáforos C, D, E
+    READ_PROTOCOL_SEQLOCK = 1    // lectura optimista con el contador H, sin escribir en memoria compartida
+} read_protocol_t;
+
+typedef enum {
+    MOVE_TRANSPORT_PIPE = 0,     // un byte por movimiento en stdout (protocolo de la cátedra)
+    MOVE_TRANSPORT_RING = 1      // buffer circular por jugador en la región de movimientos (move_ring.h)
+} move_transport_t;
+
 
 static inline int idx(int x, int y, int width) {
     return y * width + x;
@@ -138,8 +186,101 @@ static inline bool is_valid_direction(unsigned char dir) {
 }
 
 
-static inline size_t game_state_size(int width, int height) {
-    return sizeof(game_state_t) + (width * height * sizeof(int));
+static inline size_t board_cell_bytes(board_format_t format) {
+    return format == BOARD_FORMAT_COMPACT ? sizeof(int8_t) : sizeof(int);
+}
+
+// Offset (desde el inicio de game_state_t) del bitmap de celdas libres del formato compacto
+static inline size_t free_bitmap_offset(int width, int height) {
+    return (sizeof(game_state_t) + (size_t)width * height + 7) & ~(size_t)7;
+}
+
+static inline size_t free_bitmap_words(int width, int height) {
+    return ((size_t)width * height + 63) / 64;
+}
+
+static inline size_t game_state_size(int width, int height, board_format_t format) {
+    if (format == BOARD_FORMAT_COMPACT)
+        return free_bitmap_offset(width, height) + free_bitmap_words(width, height) * sizeof(uint64_t);
+    return sizeof(game_state_t) + ((size_t)width * height * sizeof(int));
+}
+
+static inline int8_t *board_cells8(game_state_t *gs) {
+    return (int8_t *)gs->board;
+}
+
+static inline uint64_t *free_bitmap(game_state_t *gs) {
+    return (uint64_t *)((char *)gs + free_bitmap_offset(gs->board_width, gs->board_height));
+}
+
+static inline int board_get(const game_state_t *gs, board_format_t format, int i) {
+    return format == BOARD_FORMAT_COMPACT ? ((const int8_t *)gs->board)[i] : gs->board[i];
+}
+
+// Cantidad de celdas libres según el bitmap del formato compacto
+static inline size_t count_free_cells(const uint64_t *bits, size_t words) {
+    size_t n = 0;
+    for (size_t w = 0; w < words; w++)
+        n += (size_t)__builtin_popcountll(bits[w]);
+    return n;
+}
+
+
+// Log circular de cambios del tablero. El master agrega una entrada por cada celda que
+// cambia y los lectores aplican solo las posteriores a la última que vieron
+#define DELTA_LOG_CAPACITY 4096 // potencia de 2
+
+typedef struct {
+    unsigned int cell;      // índice de la celda (idx)
+    int value;              // nuevo valor de la celda
+    unsigned int player;    // jugador que la capturó
+} board_delta_t;
+
+typedef struct {
+    unsigned long long head;   // cantidad de cambios publicados desde el inicio
+    unsigned int capacity;     // cantidad de entradas del buffer
+    unsigned int reserved;
+    board_delta_t entries[];
+} delta_log_t;
+
+static inline size_t delta_log_offset(int width, int height, board_format_t format) {
+    return (game_state_size(width, height, format) + 63) & ~(size_t)63;
+}
+
+static inline size_t delta_log_size(unsigned capacity) {
+    return sizeof(delta_log_t) + capacity * sizeof(board_delta_t);
+}
+
+
+// Jugadores a partir de MAX_PLAYERS: su player_t va en una tabla después del log de cambios
+// y su semáforo G en un arreglo a continuación de game_sync_t
+static inline size_t extra_players_offset(int width, int height, board_format_t format) {
+    return delta_log_offset(width, height, format) + ((delta_log_size(DELTA_LOG_CAPACITY) + 63) & ~(size_t)63);
+}
+
+static inline unsigned extra_player_count(unsigned num_players) {
+    return num_players > MAX_PLAYERS ? num_players - MAX_PLAYERS : 0;
+}
+
+// Tamaño total de la región de estado que crea el master (estado, log de cambios y tabla de jugadores extra)
+static inline size_t game_state_region_size(int width, int height, board_format_t format, unsigned num_players) {
+    return extra_players_offset(width, height, format) + extra_player_count(num_players) * sizeof(player_t);
+}
+
+static inline size_t game_sync_size(unsigned num_players) {
+    return sizeof(game_sync_t) + extra_player_count(num_players) * sizeof(sem_t);
+}
+
+static inline player_t *game_player(game_state_t *gs, player_t *extra, unsigned i) {
+    return i < MAX_PLAYERS ? &gs->players[i] : &extra[i - MAX_PLAYERS];
+}
+
+static inline const player_t *game_player_ro(const game_state_t *gs, const player_t *extra, unsigned i) {
+    return i < MAX_PLAYERS ? &gs->players[i] : &extra[i - MAX_PLAYERS];
+}
+
+static inline sem_t *player_sem(game_sync_t *sync, unsigned i) {
+    return i < MAX_PLAYERS ? &sync->player_ready[i] : &((sem_t *)(sync + 1))[i - MAX_PLAYERS];
 }
 
 
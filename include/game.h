@@ -0,0 +1,38 @@
+#ifndef GAME_H
+#define GAME_H
+
+#pragma once
+#include "common.h"
+
+// Cómo se generan las recompensas del tablero a partir de la semilla
+typedef enum {
+    BOARD_GEN_RAND = 0,      // srand(seed) + rand(), en serie: los tableros de siempre para cada semilla
+    BOARD_GEN_COUNTER = 1,   // hash de la semilla y el índice de cada celda, llenado en paralelo
+} board_gen_t;
+
+typedef struct {
+    game_state_t *state;     // estado (en memoria compartida o privada)
+    board_format_t format;   // formato de las celdas de state->board
+    delta_log_t *deltas;     // log de cambios del tablero, NULL si no se publica
+    player_t *extra_players; // jugadores a partir de MAX_PLAYERS, NULL si no hay
+    uint8_t *free_neighbors; // celdas libres alrededor de cada celda, NULL si no se lleva la cuenta
+    unsigned num_blocked;    // jugadores con is_blocked
+} game_t;
+
+// Reglas del juego, sin sincronización: el llamador debe tener el lock de escritura
+// El resultado solo depende de la semilla y el generador, no de cuántos threads se usen
+void init_board(game_t *g, unsigned seed, board_gen_t gen);
+void place_players(game_t *g);
+// Ubica al jugador i en (x,y) y captura esa celda (place_players lo hace para todos)
+void place_player_at(game_t *g, int i, int x, int y);
+int apply_move(game_t *g, int pid_idx, unsigned char dir);
+
+// Cuenta las celdas libres alrededor de cada celda (después de place_players). Desde ahí cada
+// captura actualiza sus 8 vecinas y apply_move bloquea al jugador que se queda sin movimientos,
+// sin recorrer el tablero. -1 si no hay memoria (la partida sigue sin la cuenta)
+int game_track_neighbors(game_t *g);
+void game_untrack_neighbors(game_t *g);
+// Marca al jugador como bloqueado (también cuando cierra su pipe); no hace nada si ya lo estaba
+void block_player(game_t *g, unsigned i);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#pragma once
+#include <stdio.h>
+#include <time.h>
+#include "common.h"
+
+// Latencia de cada etapa de un turno en el master, por jugador, en histogramas log-lineales:
+// cada potencia de 2 se parte en 2^LAT_SUB_BITS baldes iguales, así el error relativo de un
+// percentil queda acotado (6.25%) sin importar la escala. Con CHOMP_LATENCY en 0 (make LATENCY=0)
+// las macros de instrumentación no generan código.
+
+#ifndef CHOMP_LATENCY
+#define CHOMP_LATENCY 1
+#endif
+
+#define LAT_SUB_BITS 4
+#define LAT_MAX_BITS 40      // valores desde 2^40 ns (unos 18 minutos) van al último balde
+#define LAT_BUCKETS ((LAT_MAX_BITS - LAT_SUB_BITS + 1) << LAT_SUB_BITS)
+
+typedef enum {
+    LAT_POST = 0,   // sem_post(player_ready[i])
+    LAT_TURN,       // desde el sem_post hasta que llega el movimiento
+    LAT_LOCK,       // espera de writer_enter
+    LAT_APPLY,      // apply_move
+    LAT_VIEW,       // handshake con la vista
+    LAT_DELAY,      // desde que se procesó el movimiento hasta el turno del próximo tick
+    LAT_STAGES
+} lat_stage_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t max;
+    uint32_t buckets[LAT_BUCKETS];
+} lat_hist_t;
+
+static inline unsigned lat_bucket(uint64_t ns) {
+    if (ns < (1u << LAT_SUB_BITS))
+        return (unsigned)ns;
+    unsigned msb = 63u - (unsigned)__builtin_clzll(ns);
+    if (msb >= LAT_MAX_BITS)
+        return LAT_BUCKETS - 1;
+    unsigned shift = msb - LAT_SUB_BITS;
+    return ((shift + 1) << LAT_SUB_BITS) + (unsigned)((ns >> shift) & ((1u << LAT_SUB_BITS) - 1));
+}
+
+static inline void lat_hist_record(lat_hist_t *h, uint64_t ns) {
+    h->buckets[lat_bucket(ns)]++;
+    h->count++;
+    if (ns > h->max)
+        h->max = ns;
+}
+
+static inline uint64_t lat_span_ns(const struct timespec *from, const struct timespec *to) {
+    long long ns = (to->tv_sec - from->tv_sec) * 1000000000LL + (to->tv_nsec - from->tv_nsec);
+    return ns > 0 ? (uint64_t)ns : 0;
+}
+
+// Tabla de LAT_STAGES histogramas por jugador; NULL si no se pudo reservar
+lat_hist_t *lat_table_create(unsigned num_players);
+
+static inline void lat_record(lat_hist_t *table, unsigned player, lat_stage_t stage,
+                              const struct timespec *from, const struct timespec *to) {
+    if (table)
+        lat_hist_record(&table[(size_t)player * LAT_STAGES + stage], lat_span_ns(from, to));
+}
+
+// Cota superior del balde donde cae el percentil p (0..100), sin pasarse del máximo visto
+uint64_t lat_hist_percentile(const lat_hist_t *h, double p);
+const char *lat_stage_name(lat_stage_t stage);
+// Una línea por jugador y etapa con muestras (p50/p99/p999/max en ns) y el total de cada etapa
+void lat_table_print(FILE *out, const lat_hist_t *table, unsigned num_players);
+
+#if CHOMP_LATENCY
+#define LAT_DECL(...) struct timespec __VA_ARGS__
+#define LAT_STAMP(ts) clock_gettime(CLOCK_MONOTONIC, &(ts))
+#define LAT_RECORD(table, player, stage, from, to) lat_record((table), (player), (stage), &(from), &(to))
+#else
+#define LAT_DECL(...)
+#define LAT_STAMP(ts) ((void)0)
+#define LAT_RECORD(table, player, stage, from, to) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#pragma once
+#include "common.h"
+#include "latency.h"
+#include "game.h"
+
+// Jugadores que siguen vivos entre partidas (ver player_pool_create)
+typedef struct player_pool player_pool_t;
+// Estrategia cargada de una biblioteca compartida (plugin.h)
+typedef struct plugin plugin_t;
+
+typedef struct {
+    int board_width;
+    int board_height;
+    int delay_ms;            // período del tick: cada jugador recibe a lo sumo un turno por tick (0: sin ticks)
+    int timeout_s;
+    int turn_ms;             // plazo de cada turno en ms; el que no contesta a tiempo lo pierde (0: sin plazo)
+    unsigned seed;
+    const char *view_bin;
+    int view_fps;            // > 0: vista asíncrona con ese máximo de cuadros por segundo
+    char **player_bins;      // ejecutables de los jugadores (apuntan a argv)
+    int num_players;
+    const char *shm_state;   // nombre de la región de estado (NULL: SHM_STATE)
+    const char *shm_sync;    // nombre de la región de sincronización (NULL: SHM_SYNC)
+    const char *shm_moves;   // nombre de la región de movimientos (NULL: SHM_MOVES), solo con MOVE_TRANSPORT_RING
+    const char *shm_stats;   // nombre de la región de estadísticas (NULL: SHM_STATS)
+    read_protocol_t read_protocol;  // protocolo de lectura que usan nuestros jugadores y vista
+    unsigned state_map_opts;        // opciones SHM_MAP_* para la región de estado
+    board_format_t board_format;    // formato del tablero (el compacto no lo entienden los jugadores de la cátedra)
+    board_gen_t board_gen;          // generador de las recompensas del tablero
+    bool batch_moves;               // aplicar los movimientos de cada ronda bajo un único lock de escritura
+    move_transport_t move_transport; // pipe (protocolo de la cátedra) o buffers circulares en memoria compartida
+    const char *record_path;        // archivo donde grabar la partida (record.h), NULL para no grabar
+    bool early_finish;              // terminar apenas ningún puntaje puede cambiar (reach.h)
+    player_pool_t *pool;            // jugadores ya lanzados para reusar, NULL para lanzarlos en cada partida
+    plugin_t **plugins;             // una estrategia por jugador jugada en el proceso, NULL para lanzar procesos
+} game_args_t;
+
+// "rw" o "seqlock"; devuelve -1 si no es ninguno
+int parse_read_protocol(const char *name);
+// "pipe" o "ring"; devuelve -1 si no es ninguno
+int parse_move_transport(const char *name);
+// "rand" o "counter"; devuelve -1 si no es ninguno
+int parse_board_gen(const char *name);
+// Lista separada por comas de "huge", "prefault" y "lock"; devuelve -1 si hay alguna desconocida
+int parse_map_opts(const char *list);
+
+typedef struct {
+    unsigned num_players;
+    player_t *players;               // estado final de cada jugador
+    int *exit_codes;                 // código de salida (o señal) de cada jugador
+    int view_status;                 // status de waitpid de la vista, -1 si no hubo vista
+    long duration_us;                // duración de la partida desde el primer movimiento
+    size_t state_bytes;              // tamaño de la región de estado
+    long map_us;                     // tiempo de crear y mapear la región de estado
+    long init_us;                    // tiempo de init_board (primer recorrido del tablero)
+    long map_faults;                 // fallos de página menores del master al mapear
+    long init_faults;                // fallos de página menores del master en init_board
+    unsigned long moves_applied;     // movimientos aplicados (válidos o inválidos)
+    unsigned long move_locks;        // adquisiciones del lock de escritura para aplicarlos
+    unsigned long turns_timed;       // turnos medidos desde el sem_post hasta que llega el movimiento
+    long turn_rtt_avg_ns;            // promedio de esa ida y vuelta
+    lat_hist_t *latency;             // LAT_STAGES histogramas por jugador (latency.h), NULL si no se midió
+    bool decided;                    // con early_finish: terminó porque ningún puntaje podía cambiar
+    unsigned long turns_forfeited;   // con turn_ms: turnos perdidos por no contestar a tiempo
+} game_result_t;
+
+// Corre una partida completa: crea las memorias, lanza vista y jugadores, y espera que terminen.
+// Devuelve SUCCESS o uno de los códigos de error de common.h
+// Las tablas de result se liberan con game_result_free (también si devuelve error)
+int run_game(const game_args_t *args, game_result_t *result);
+void game_result_free(game_result_t *result);
+// Con muchos jugadores (o muchas partidas en el mismo proceso) el master necesita un descriptor
+// por pipe: sube el límite blando para num_players pipes más un margen
+void ensure_fd_limit(unsigned num_players);
+
+// Pool de jugadores para partidas sucesivas con los mismos ejecutables: cada uno se lanza una
+// vez (con CHOMP_POOL=1, ver common.h) y en cada partida recibe por stdin las dimensiones y los
+// nombres de las regiones; run_game espera su POOL_GAME_DONE en lugar de su exit. Un jugador
+// que muere o no suelta la partida a tiempo se relanza en la próxima. Los jugadores de la
+// cátedra no entienden este protocolo. Ignora SIGPIPE en el proceso.
+player_pool_t *player_pool_create(char **player_bins, unsigned num_players);
+// Cierra el stdin de cada jugador (con eso terminan) y los espera
+void player_pool_destroy(player_pool_t *pool);
+
+// Jugadores en biblioteca compartida: si todos los ejecutables terminan en .so los carga en
+// *plugins (dlopen abre una sola vez cada archivo) y devuelve 1; 0 si ninguno es un plugin y -1
+// (con el motivo en stderr) si se mezclan o alguno no se pudo cargar
+int plugins_load(char **paths, unsigned num_players, plugin_t ***plugins);
+void plugins_unload(plugin_t **plugins, unsigned num_players);
+// La partida de run_game con args->plugins: sin procesos ni memoria compartida, en rondas donde
+// cada jugador no bloqueado elige con su pick_dir sobre el tablero de la partida. Sin vista
+int run_plugin_game(const game_args_t *args, game_result_t *result);
+
+#endif
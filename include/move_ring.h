@@ -0,0 +1,97 @@
+#ifndef MOVE_RING_H
+#define MOVE_RING_H
+
+#pragma once
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "common.h"
+
+// Canal de movimientos sin syscalls: un buffer circular de un productor (el jugador) y un
+// consumidor (el master) por jugador. El master solo duerme, con futex, cuando todos están vacíos.
+// Cada jugador marca su buffer en el bitmap nonempty junto al timbre, así el master lee solo los
+// buffers marcados y no todos en cada despertada.
+
+#define MOVE_RING_CAPACITY 64   // potencia de 2; con un movimiento por turno nunca se llena
+
+typedef struct {
+    _Alignas(64) uint32_t head;      // próximo lugar a escribir; solo lo modifica el jugador
+    uint32_t closed;                 // el jugador no va a mandar más movimientos (el EOF del pipe)
+    _Alignas(64) uint32_t tail;      // próximo lugar a leer; solo lo modifica el master
+    _Alignas(64) unsigned char moves[MOVE_RING_CAPACITY];
+} move_ring_t;
+
+typedef struct move_rings {
+    _Alignas(64) uint32_t doorbell;  // se incrementa con cada movimiento o cierre
+    uint32_t master_waiting;         // el master está por dormirse en doorbell
+    uint32_t num_rings;
+    uint64_t nonempty[MAX_PLAYERS_EXT / 64]; // bit i: el buffer i recibió algo desde que el master lo limpió
+    _Alignas(64) move_ring_t rings[];
+} move_rings_t;
+
+static inline size_t move_rings_size(unsigned num_players) {
+    return sizeof(move_rings_t) + num_players * sizeof(move_ring_t);
+}
+
+// Futex compartido entre procesos (sin FUTEX_PRIVATE_FLAG)
+static inline long futex_wait(uint32_t *addr, uint32_t expected, const struct timespec *timeout) {
+    return syscall(SYS_futex, addr, FUTEX_WAIT, expected, timeout, NULL, 0);
+}
+
+static inline long futex_wake(uint32_t *addr, int count) {
+    return syscall(SYS_futex, addr, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+// Marca el buffer y toca el timbre. El bit va después de escribir el buffer: si el master lo ve,
+// también ve lo escrito. Solo hay syscall si el master anunció que se va a dormir
+static inline void move_rings_notify(move_rings_t *r, unsigned i) {
+    __atomic_fetch_or(&r->nonempty[i / 64], 1ULL << (i % 64), __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&r->doorbell, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&r->master_waiting, __ATOMIC_SEQ_CST))
+        futex_wake(&r->doorbell, 1);
+}
+
+static inline void move_ring_push(move_rings_t *r, unsigned i, unsigned char move) {
+    move_ring_t *ring = &r->rings[i];
+    uint32_t head = ring->head;
+    while (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= MOVE_RING_CAPACITY)
+        sched_yield();
+    ring->moves[head & (MOVE_RING_CAPACITY - 1)] = move;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    move_rings_notify(r, i);
+}
+
+static inline void move_ring_close(move_rings_t *r, unsigned i) {
+    __atomic_store_n(&r->rings[i].closed, 1, __ATOMIC_RELEASE);
+    move_rings_notify(r, i);
+}
+
+// Copia hasta max movimientos pendientes en out; devuelve cuántos copió
+static inline unsigned move_ring_pop(move_ring_t *ring, unsigned char *out, unsigned max) {
+    uint32_t tail = ring->tail;
+    uint32_t avail = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+    unsigned n = avail < max ? avail : max;
+    for (unsigned k = 0; k < n; k++)
+        out[k] = ring->moves[(tail + k) & (MOVE_RING_CAPACITY - 1)];
+    __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+static inline bool move_ring_empty(const move_ring_t *ring) {
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == ring->tail;
+}
+
+// Toma los bits de los buffers 64 * word .. 64 * word + 63 y los deja en cero
+static inline uint64_t move_rings_take_nonempty(move_rings_t *r, unsigned word) {
+    if (!__atomic_load_n(&r->nonempty[word], __ATOMIC_RELAXED))
+        return 0;
+    return __atomic_exchange_n(&r->nonempty[word], 0, __ATOMIC_SEQ_CST);
+}
+
+static inline bool move_ring_closed(const move_ring_t *ring) {
+    return __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE) != 0;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef NEIGHBORS_H
+#define NEIGHBORS_H
+
+#pragma once
+#include "common.h"
+
+// Vecindario de 8 celdas con SIMD: en x86 se elige en tiempo de ejecución entre AVX2, SSE4.1
+// y la versión escalar, que es la única en otras arquitecturas. Todas dan el mismo resultado.
+
+typedef enum {
+    NEIGHBORS_SCALAR = 0,
+    NEIGHBORS_SSE41,
+    NEIGHBORS_AVX2,
+    NEIGHBORS_IMPLS
+} neighbors_impl_t;
+
+// La mejor implementación que soporta esta CPU
+neighbors_impl_t neighbors_best_impl(void);
+bool neighbors_impl_supported(neighbors_impl_t impl);
+const char *neighbors_impl_name(neighbors_impl_t impl);
+
+// Los 8 vecinos de (x,y) en el orden de direction_t; los que no son celdas libres (ocupados o
+// fuera del tablero) valen 0
+void neighbors_gather(const int board[], int width, int height, int x, int y, int out[NUM_DIRECTIONS]);
+
+// Dirección del vecino libre de mayor recompensa (la primera en orden de direction_t si hay
+// empate), o -1 si no hay ninguno. Si free_count no es NULL recibe la cantidad de vecinos libres.
+int neighbors_best_dir(neighbors_impl_t impl, const int board[], int width, int height, int x, int y, int *free_count);
+
+// Mapa de todo el tablero en una pasada: para cada celda, la mayor recompensa entre sus vecinos
+// libres (0 si no hay) y cuántos vecinos libres tiene
+void neighbors_map(neighbors_impl_t impl, const int board[], int width, int height, uint8_t *best, uint8_t *free_count);
+
+// Estrategia por defecto del jugador: neighbors_best_dir con la implementación más rápida para una celda
+int pick_dir(const int board[], int width, int height, int x, int y);
+
+#endif
@@ -3,6 +3,4 @@
 
 #define NUM_ARGS 3 
 
-int pick_dir(int board[], int width, int height, int x, int y);
-
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+#pragma once
+#include "common.h"
+
+// ABI de las estrategias en biblioteca compartida. Cada .so exporta un chomp_plugin_t con el
+// nombre CHOMP_PLUGIN_SYMBOL; el master lo carga con dlopen y llama a pick_dir en su propio
+// proceso con el tablero de la partida (formato int, sin copia, sin memoria compartida ni pipes).
+// El mismo fuente enlazado con player.c es un jugador común (ver plugins/ en el Makefile).
+
+#define CHOMP_PLUGIN_ABI 1
+#define CHOMP_PLUGIN_SYMBOL "chomp_plugin"
+#define CHOMP_PLUGIN_SUFFIX ".so"
+
+typedef struct {
+    unsigned abi;              // CHOMP_PLUGIN_ABI
+    const char *name;          // nombre del jugador en la tabla (se corta a MAX_NAME_LEN)
+    // Estado propio de cada jugador que usa la estrategia (player es su índice); NULL si no hace
+    // falta, y entonces pick_dir recibe ctx NULL
+    void *(*create)(int width, int height, unsigned player);
+    // Como pick_dir de neighbors.h: dirección (direction_t) o -1 si no hay movimientos. board no
+    // se puede modificar y solo es válido durante la llamada
+    int (*pick_dir)(const int board[], int width, int height, int x, int y, void *ctx);
+    void (*destroy)(void *ctx); // puede ser NULL
+} chomp_plugin_t;
+
+#endif
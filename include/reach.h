@@ -0,0 +1,45 @@
+#ifndef REACH_H
+#define REACH_H
+
+#pragma once
+#include "common.h"
+#include "game.h"
+
+// Componentes conexas (8 vecinos) de las celdas libres, mantenidas a medida que se capturan
+// celdas. Una captura solo achica su componente, salvo que parta su vecindario en varios grupos:
+// ahí se buscan los grupos en paralelo, de a una celda por vez, y cuando queda uno solo sin
+// terminar los demás (los chicos) pasan a ser componentes nuevas. Las componentes nunca se
+// unen, así que lo que un jugador puede sumar de acá en adelante está acotado por las
+// componentes que toca ahora.
+
+#define REACH_MAX_SEARCHES 4   // grupos de libres que puede dejar una celda entre sus 8 vecinas
+
+typedef struct {
+    uint32_t size;             // celdas libres; 0 si la componente ya no existe
+    uint32_t reward;           // suma de sus recompensas
+} reach_comp_t;
+
+typedef struct {
+    int width, height;
+    uint32_t *label;           // componente de cada celda libre, 0 si está ocupada
+    reach_comp_t *comps;       // comps[0] no se usa
+    uint32_t num_comps, cap_comps;
+    uint32_t *mark;            // (ronda << 2) | búsqueda que visitó la celda
+    uint32_t round;
+    uint32_t *queue[REACH_MAX_SEARCHES];
+    size_t queue_cap[REACH_MAX_SEARCHES];
+} reach_t;
+
+// Etiqueta el tablero actual; -1 si no hay memoria
+int reach_init(reach_t *r, const game_t *g);
+void reach_free(reach_t *r);
+
+// La celda cell (que valía reward) dejó de estar libre
+void reach_capture(reach_t *r, const game_t *g, int cell, unsigned reward);
+
+// true si ningún puntaje puede cambiar: ningún jugador sin bloquear toca una componente con
+// recompensas. Que una componente la toque un solo jugador no alcanza, porque lo que termine
+// sumando depende de cómo juegue
+bool reach_decided(const reach_t *r, const game_t *g);
+
+#endif
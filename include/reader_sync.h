@@ -2,8 +2,11 @@
 #define READER_SYNC_H
 
 #pragma once
+#include <sched.h>
 #include "common.h"
 
+#define SEQ_SPINS_BEFORE_YIELD 64
+
 
 static inline void reader_enter(game_sync_t *s) {
     sem_wait(&s->writer_mutex); 
@@ -21,4 +24,40 @@ static inline void reader_exit(game_sync_t *s) {
     sem_post(&s->reader_count_mutex);
 }
 
+// Seqlock: espera a que no haya escritura en curso y devuelve el valor de H
+static inline unsigned seq_read_begin(const game_sync_t *s) {
+    unsigned seq;
+    int spins = 0;
+    while ((seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE)) & 1u) {
+        if (++spins >= SEQ_SPINS_BEFORE_YIELD) {
+            spins = 0;
+            sched_yield();
+        }
+    }
+    return seq;
+}
+
+// true si la copia leída desde seq_read_begin es consistente
+static inline bool seq_read_valid(const game_sync_t *s, unsigned start) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&s->seq, __ATOMIC_RELAXED) == start;
+}
+
+// Lectura con cualquiera de los dos protocolos:
+//     do { t = snapshot_begin(s, p); ...copiar... } while (!snapshot_end(s, p, t));
+// Con READ_PROTOCOL_RW la copia siempre es válida; con SEQLOCK se reintenta si hubo una escritura
+static inline unsigned snapshot_begin(game_sync_t *s, read_protocol_t protocol) {
+    if (protocol == READ_PROTOCOL_SEQLOCK)
+        return seq_read_begin(s);
+    reader_enter(s);
+    return 0;
+}
+
+static inline bool snapshot_end(game_sync_t *s, read_protocol_t protocol, unsigned token) {
+    if (protocol == READ_PROTOCOL_SEQLOCK)
+        return seq_read_valid(s, token);
+    reader_exit(s);
+    return true;
+}
+
 #endif
\ No newline at end of file
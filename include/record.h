@@ -0,0 +1,86 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#pragma once
+#include "common.h"
+#include "game.h"
+
+// Grabación binaria de una partida:
+//   record_header_t
+//   por jugador: varint x, varint y (resultado de place_players), varint largo + nombre
+//   eventos: varint (delta de jugador * RECORD_KINDS + tipo) [+ byte crudo si es RECORD_RAW]
+//   RECORD_END: varint num_players y por jugador varint score, valid_moves, invalid_moves
+// El delta es (jugador - jugador del evento anterior) mod num_players: con el turno rotativo
+// casi siempre es chico y cada movimiento ocupa un byte.
+
+#define RECORD_MAGIC "CHOMPREC"
+#define RECORD_VERSION 1
+#define RECORD_BOARD_GEN_RAND BOARD_GEN_RAND         // tablero de init_board: srand(seed) + rand()
+#define RECORD_BOARD_GEN_COUNTER BOARD_GEN_COUNTER   // tablero de init_board: generador por contador
+
+typedef enum {
+    RECORD_DIR_FIRST = 0,         // 0..7: movimiento en esa dirección
+    RECORD_RAW = NUM_DIRECTIONS,  // byte que no es una dirección (cuenta como inválido), va a continuación
+    RECORD_GONE,                  // el jugador cerró su pipe: queda bloqueado
+    RECORD_END,                   // fin de la partida, siguen los resultados
+    RECORD_KINDS
+} record_kind_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint16_t width, height;
+    uint32_t num_players;
+    uint32_t seed;
+    uint32_t board_format;        // board_format_t
+    uint32_t board_gen;           // RECORD_BOARD_GEN_*
+} record_header_t;
+
+typedef struct {
+    int fd;
+    unsigned char *buf;
+    size_t len, cap;
+    unsigned num_players;
+    unsigned last_player;
+    unsigned long events;
+    bool failed;                  // falló algún write: se deja de grabar
+} recorder_t;
+
+// Crea el archivo y escribe el encabezado y las posiciones iniciales
+int recorder_open(recorder_t *r, const char *path, const record_header_t *h, const game_state_t *gs, const player_t *extra);
+void recorder_move(recorder_t *r, unsigned player, unsigned char move);
+void recorder_gone(recorder_t *r, unsigned player);
+// Escribe los resultados, vacía el buffer y cierra; -1 si algo no se pudo escribir
+int recorder_close(recorder_t *r, const game_state_t *gs, const player_t *extra);
+
+typedef struct {
+    unsigned char kind;           // record_kind_t
+    unsigned char move;           // byte que mandó el jugador (RECORD_DIR_FIRST..RECORD_RAW)
+    unsigned player;
+} record_event_t;
+
+typedef struct {
+    const unsigned char *base;    // archivo mapeado
+    size_t size, pos;
+    record_header_t header;
+    unsigned last_player;
+} record_reader_t;
+
+// Mapea el archivo y valida el encabezado
+int record_reader_open(record_reader_t *rd, const char *path);
+// Posición inicial y nombre del jugador i (en orden: se llama para i = 0..num_players-1)
+int record_reader_player(record_reader_t *rd, player_t *p);
+// 1 si leyó un evento, 0 al llegar a RECORD_END o al final del archivo, -1 si está corrupto
+int record_reader_next(record_reader_t *rd, record_event_t *ev);
+// Después de RECORD_END: score, valid_moves e invalid_moves finales de cada jugador en out[0..n-1];
+// -1 si no están (partida cortada)
+int record_reader_results(record_reader_t *rd, player_t *out, unsigned n);
+void record_reader_close(record_reader_t *rd);
+
+// Arma en g el tablero de la semilla y las posiciones iniciales de la grabación. g->state ya
+// tiene lugar para el tablero del encabezado (y g->extra_players si hay más de MAX_PLAYERS)
+int record_game_setup(record_reader_t *rd, game_t *g);
+// Aplica un evento con las mismas reglas que el master; 1 si cambió el estado
+int record_apply(game_t *g, const record_event_t *ev);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#pragma once
+#include "common.h"
+
+// Búsqueda con profundización iterativa para el jugador: negamax con poda alfa-beta entre el
+// jugador y su oponente más cercano, sobre una ventana del tablero centrada en el jugador
+
+#define ENV_PLAYER_STRATEGY "CHOMP_STRATEGY"       // "greedy" (por defecto) o "search"
+#define ENV_SEARCH_MS "CHOMP_SEARCH_MS"            // tiempo por movimiento en ms
+#define ENV_SEARCH_THREADS "CHOMP_SEARCH_THREADS"  // threads de búsqueda
+
+#define SEARCH_DEFAULT_MS 20
+#define SEARCH_MAX_THREADS 64
+#define SEARCH_SPAN 64       // lado de la ventana; lo que queda afuera se toma como ocupado
+#define SEARCH_MAX_DEPTH 64
+
+typedef struct {
+    unsigned short x, y;
+    bool blocked;
+} search_player_t;
+
+typedef struct {
+    unsigned budget_ms;      // tiempo por movimiento
+    unsigned threads;        // incluye al thread que llama a search_pick_dir
+} search_config_t;
+
+typedef struct search search_t;
+
+// Configuración por defecto, sobrescrita por las variables de entorno ENV_SEARCH_*
+search_config_t search_config_from_env(void);
+search_t *search_create(const search_config_t *cfg);
+void search_destroy(search_t *s);
+
+// Mejor dirección para el jugador me, o -1 si no tiene celdas libres alrededor
+int search_pick_dir(search_t *s, const int board[], int width, int height,
+                    const search_player_t *players, unsigned num_players, unsigned me);
+
+// Profundidad completada y nodos visitados en la última búsqueda
+unsigned search_last_depth(const search_t *s);
+unsigned long search_last_nodes(const search_t *s);
+
+#endif
@@ -7,16 +7,56 @@
 #include "common.h"
 
 typedef struct shm_cdt * shm_adt;
+typedef struct move_rings move_rings_t; // move_ring.h
+typedef struct game_stats game_stats_t; // stats.h
+
+// Opciones de mapeo de la región de estado (se pueden combinar)
+#define SHM_MAP_HUGEPAGES 0x1u   // alinear a 2 MiB y pedir páginas grandes con madvise
+#define SHM_MAP_PREFAULT  0x2u   // reservar las páginas al crear y cargarlas al mapear
+#define SHM_MAP_LOCK      0x4u   // mlock de toda la región (también la carga)
+
+#define HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
 
 int shm_region_open(shm_adt* out_handle, const char* name, size_t size_bytes);
 int shm_region_open_readonly(shm_adt* out_handle, const char* name, size_t size_bytes);
+// Lectura y escritura de una región que ya existe: nunca la crea
+int shm_region_open_existing(shm_adt* out_handle, const char* name);
 int shm_region_close(shm_adt handle);
 
-int game_state_map(shm_adt handle, unsigned short width, unsigned short height, game_state_t** out_state);
-int game_state_map_readonly(shm_adt handle, unsigned short width, unsigned short height, game_state_t** out_state);
+// Nombre de la región tomado de la variable de entorno env_var, o default_name si no está
+const char *shm_region_name(const char *env_var, const char *default_name);
+
+int game_state_map(shm_adt handle, unsigned short width, unsigned short height, board_format_t format, unsigned opts, game_state_t** out_state);
+int game_state_map_readonly(shm_adt handle, unsigned short width, unsigned short height, board_format_t format, unsigned opts, game_state_t** out_state);
 int game_sync_map (shm_adt handle, game_sync_t** out_sync);
 
+// true si la región de sync mapeada fue creada por este master y trae las extensiones
+bool game_sync_has_ext(shm_adt handle);
+// Protocolo de lectura elegido por el master (READ_PROTOCOL_RW si la región no tiene extensiones)
+read_protocol_t game_sync_read_protocol(shm_adt handle);
+// Opciones SHM_MAP_* con las que el master mapeó el estado (0 si la región no tiene extensiones)
+unsigned game_sync_state_map_opts(shm_adt handle);
+// Formato del tablero elegido por el master (BOARD_FORMAT_INT si la región no tiene extensiones)
+board_format_t game_sync_board_format(shm_adt handle);
+// Transporte de movimientos elegido por el master (MOVE_TRANSPORT_PIPE si la región no tiene extensiones)
+move_transport_t game_sync_move_transport(shm_adt handle);
+// Cuadros por segundo de la vista asíncrona (0: la vista dibuja cada cambio, como con el master de la cátedra)
+unsigned game_sync_view_fps(shm_adt handle);
+// Log de cambios que el master publica después del tablero, NULL si la región no lo trae
+const delta_log_t *game_state_delta_log(shm_adt state_handle, shm_adt sync_handle, unsigned short width, unsigned short height);
+// Tabla de jugadores a partir de MAX_PLAYERS, NULL si la región no la trae
+const player_t *game_state_extra_players(shm_adt state_handle, shm_adt sync_handle, unsigned short width, unsigned short height);
+
+// Buffers de movimientos de los jugadores; num_players es la cantidad mínima que tiene que traer
+int move_rings_map(shm_adt handle, unsigned num_players, move_rings_t **out_rings);
+
+// Región de contadores (stats.h): el master la crea para num_players; los demás la abren ya creada
+int game_stats_map(shm_adt handle, unsigned num_players, game_stats_t **out_stats);
+int game_stats_map_readonly(shm_adt handle, const game_stats_t **out_stats);
+
 int game_state_unmap_destroy(shm_adt handle);
+int move_rings_unmap_destroy(shm_adt handle);
+int game_stats_unmap_destroy(shm_adt handle);
 int game_sync_unmap_destroy (shm_adt handle);
 
 #endif
\ No newline at end of file
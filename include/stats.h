@@ -0,0 +1,60 @@
+#ifndef STATS_H
+#define STATS_H
+
+#pragma once
+#include "common.h"
+
+// Contadores de la partida en su propia región de memoria compartida, aparte del estado y de la
+// sincronización: se actualizan sin tomar ningún lock del juego y bin/stat los lee cuando quiere.
+// Cada contador tiene un único proceso que lo escribe (master, vista o el jugador dueño de la
+// entrada), así que alcanza con cargas y stores atómicos relajados, sin instrucciones con lock.
+
+#define SHM_STATS "/game_stats"
+#define ENV_SHM_STATS "CHOMP_SHM_STATS"
+
+#define GAME_STATS_MAGIC 0x43535453u // "CSTS"
+
+typedef struct {
+    // Escritos por el master
+    _Alignas(64) uint64_t bytes_read;   // bytes de movimientos leídos del pipe o del buffer circular
+    uint64_t reads;                     // reads (o lecturas del buffer) que trajeron algo
+    uint64_t eagain;                    // reads que volvieron con EAGAIN
+    // Escritos por el jugador
+    _Alignas(64) uint64_t turns;        // movimientos enviados
+    uint64_t snapshot_retries;          // copias del estado descartadas (seqlock)
+    uint64_t think_ns;                  // tiempo eligiendo la dirección
+} game_stats_player_t;
+
+typedef struct game_stats {
+    uint32_t magic;
+    uint32_t num_players;
+    uint32_t finished;                  // el master terminó la partida
+    uint32_t reserved;
+    uint64_t start_ns;                  // CLOCK_MONOTONIC cuando el master creó la región
+    // Escritos por el master
+    _Alignas(64) uint64_t moves_applied;
+    uint64_t moves_valid;
+    uint64_t lock_acquisitions;         // writer_enter para aplicar movimientos
+    uint64_t lock_wait_ns;              // tiempo total esperando esos writer_enter
+    uint64_t wakeups;                   // vueltas de epoll_wait o del futex de los buffers circulares
+    uint64_t view_notifies;             // cambios que se le avisaron a la vista
+    // Escritos por la vista
+    _Alignas(64) uint64_t view_frames;  // cuadros dibujados
+    uint64_t view_skipped;              // estados que la vista asíncrona no llegó a dibujar
+    _Alignas(64) game_stats_player_t players[];
+} game_stats_t;
+
+static inline size_t game_stats_size(unsigned num_players) {
+    return sizeof(game_stats_t) + num_players * sizeof(game_stats_player_t);
+}
+
+// Solo para el único proceso que escribe el contador
+static inline void stats_add(uint64_t *counter, uint64_t n) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t stats_load(const uint64_t *counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+#endif
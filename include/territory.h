@@ -0,0 +1,40 @@
+#ifndef TERRITORY_H
+#define TERRITORY_H
+
+#pragma once
+#include "common.h"
+
+// Territorio de cada jugador: las celdas libres a las que llega antes que los demás (región de
+// Voronoi con distancia de 8 vecinos). Se calcula con un BFS simultáneo desde todos los jugadores
+// sobre bitsets de filas: cada paso dilata las fronteras con shifts de palabras enteras. Las celdas
+// a las que dos jugadores llegan en el mismo paso no son de nadie.
+
+#define TERRITORY_PLANES 4   // la recompensa (1..9) en 4 planos de bits: la suma sale con popcount
+
+typedef struct {
+    int width, height;
+    int words;                        // palabras de 64 bits por fila
+    unsigned max_sources;
+    uint64_t *free_mask;              // celdas libres
+    uint64_t *planes[TERRITORY_PLANES];  // bit k de la recompensa de cada celda libre
+    uint64_t *avail;                  // libres que todavía no alcanzó nadie (durante la evaluación)
+    uint64_t *once, *twice;           // alcanzadas en este paso por uno / por más de un jugador
+    uint64_t *front, *next;           // frontera actual y siguiente de cada jugador
+} territory_t;
+
+typedef struct {
+    int x, y;                         // x < 0: el jugador no participa
+} territory_source_t;
+
+int territory_init(territory_t *t, int width, int height, unsigned max_sources);
+void territory_free(territory_t *t);
+
+// Carga el tablero entero (mismos valores que game_state_t::board)
+void territory_set_board(territory_t *t, const int board[]);
+// Cambia una celda: value entre MIN_REWARD y MAX_REWARD la deja libre, cualquier otro valor la ocupa
+void territory_set_cell(territory_t *t, int x, int y, int value);
+
+// Suma en reward[i] y cells[i] (cells puede ser NULL) lo que le toca al jugador i
+void territory_eval(territory_t *t, const territory_source_t *sources, unsigned n, unsigned *reward, unsigned *cells);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef VIEW_DRAW_H
+#define VIEW_DRAW_H
+
+#pragma once
+#include <limits.h>
+#include <ncurses.h>
+#include "common.h"
+#include "board_mirror.h"
+
+// Dibujo del tablero de la vista: solo se emiten las celdas que cambiaron desde el cuadro anterior
+
+// Pares de color
+#define C_DEFAULT 1
+#define C_PLAYER_BASE 2
+
+static inline short color_for_player(unsigned id){
+    return C_PLAYER_BASE + (id % 9);
+}
+
+#define CELL_W 4            // ancho por celda: suficiente para "p[8]" o "%3d"
+#define NOT_DRAWN INT_MIN   // celda de pantalla que todavía no se dibujó
+#define STANDING_KEY(pid) (-(1 << 20) - (int)(pid)) // no se confunde con ningún valor del tablero
+
+// Lo que quedó en pantalla del cuadro anterior, para emitir solo las celdas que cambian
+typedef struct {
+    WINDOW *win;                     // ventana donde se dibuja (stdscr en la vista)
+    int row0, col0, draw_w, draw_h;  // ventana del tablero que se ve y dónde está en pantalla
+    int *drawn;                      // clave dibujada en cada celda visible (draw_w*draw_h)
+    int *standing;                   // jugador parado en cada celda visible, -1 si no hay
+    int *occupied;                   // celdas visibles con jugador en este cuadro
+    unsigned occupied_count;
+    int *prev_occupied;              // las del cuadro anterior
+    unsigned prev_occupied_count;
+} frame_t;
+
+void frame_free(frame_t *f);
+// Ubica el tablero en f->win; si la ubicación cambió (resize, más filas de jugadores) se borra
+// la ventana, se arranca de cero y *full queda en true. Devuelve false si no entra nada
+bool frame_layout(frame_t *f, int bw, int bh, unsigned num_players, int reserve_top_rows, bool *full);
+// Índice posición→jugador de la ventana visible, O(jugadores) por cuadro
+void frame_index_players(frame_t *f, const game_state_t *gs, const player_t *extra);
+// Con full se recorre toda la ventana; si no, solo las celdas que cambiaron desde el cuadro
+// anterior (las del log de cambios y las que tenían o tienen un jugador)
+void draw_board_diff(frame_t *f, const board_mirror_t *mirror, int bw, bool full);
+
+#endif
@@ -4,12 +4,17 @@
 #pragma once
 #include "common.h"
 
+// El contador H se incrementa al entrar y al salir: los lectores con seqlock
+// ven un valor impar mientras hay una escritura en curso
 static inline void writer_enter(game_sync_t *s) {
     sem_wait(&s->writer_mutex);
     sem_wait(&s->state_mutex); 
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
 }
 
 static inline void writer_exit(game_sync_t *s) {
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
     sem_post(&s->state_mutex); 
     sem_post(&s->writer_mutex); 
 }
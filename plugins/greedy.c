@@ -0,0 +1,20 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+// Estrategia por defecto del jugador como plugin: el vecino libre de mayor recompensa
+
+#include "common.h"
+#include "neighbors.h"
+#include "plugin.h"
+
+static int greedy_pick_dir(const int board[], int width, int height, int x, int y, void *ctx) {
+    (void)ctx;
+    return pick_dir(board, width, height, x, y);
+}
+
+const chomp_plugin_t chomp_plugin = {
+    .abi = CHOMP_PLUGIN_ABI,
+    .name = "greedy",
+    .create = NULL,
+    .pick_dir = greedy_pick_dir,
+    .destroy = NULL,
+};
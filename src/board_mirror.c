@@ -0,0 +1,76 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "board_mirror.h"
+
+int board_mirror_init(board_mirror_t *m, int width, int height, board_format_t format, const delta_log_t *log) {
+    memset(m, 0, sizeof(*m));
+    m->width = width;
+    m->height = height;
+    m->format = format;
+    m->log = log;
+    m->board = malloc((size_t)width * height * sizeof(*m->board));
+    if (!m->board)
+        return -1;
+    if (log) {
+        m->pending = malloc(log->capacity * sizeof(*m->pending));
+        if (!m->pending) {
+            free(m->board);
+            m->board = NULL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void board_mirror_free(board_mirror_t *m) {
+    free(m->board);
+    free(m->pending);
+    m->board = NULL;
+    m->pending = NULL;
+}
+
+void board_mirror_read(board_mirror_t *m, const game_state_t *gs) {
+    size_t cells = (size_t)m->width * m->height;
+    unsigned long long head = m->log ? m->log->head : 0;
+    unsigned long long behind = head - m->seq;
+
+    // Con seqlock head puede leerse roto: cualquier valor fuera de rango termina en copia entera
+    if (!m->log || !m->synced || behind > m->log->capacity) {
+        m->synced = false;
+        m->pending_full = true;
+        if (m->format == BOARD_FORMAT_COMPACT) {
+            const int8_t *src = (const int8_t *)gs->board;
+            for (size_t i = 0; i < cells; i++)
+                m->board[i] = src[i];
+        } else {
+            memcpy(m->board, gs->board, cells * sizeof(*m->board));
+        }
+    } else {
+        unsigned mask = m->log->capacity - 1;
+        m->pending_full = false;
+        for (unsigned long long k = 0; k < behind; k++)
+            m->pending[k] = m->log->entries[(m->seq + k) & mask];
+        m->pending_count = (size_t)behind;
+    }
+    m->pending_head = head;
+}
+
+void board_mirror_commit(board_mirror_t *m) {
+    if (m->pending_full) {
+        m->synced = true;
+        m->full_syncs++;
+    } else {
+        size_t cells = (size_t)m->width * m->height;
+        for (size_t k = 0; k < m->pending_count; k++) {
+            if (m->pending[k].cell < cells)
+                m->board[m->pending[k].cell] = m->pending[k].value;
+        }
+        m->delta_syncs++;
+    }
+    m->seq = m->pending_head;
+}
@@ -0,0 +1,282 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "game.h"
+
+static int clamp(int v,int lo,int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static void publish_delta(delta_log_t *log, int cell, int value, int player) {
+    if (!log)
+        return;
+    board_delta_t *e = &log->entries[log->head & (log->capacity - 1)];
+    e->cell = (unsigned)cell;
+    e->value = value;
+    e->player = (unsigned)player;
+    log->head++;
+}
+
+// Escribe una celda en el formato del tablero; en el compacto también actualiza el bitmap de libres
+static void set_cell(game_t *g, int i, int value) {
+    if (g->format == BOARD_FORMAT_COMPACT) {
+        board_cells8(g->state)[i] = (int8_t)value;
+        uint64_t *word = &free_bitmap(g->state)[i >> 6];
+        uint64_t bit = 1ull << (i & 63);
+        if (cell_is_free(value))
+            *word |= bit;
+        else
+            *word &= ~bit;
+    } else {
+        g->state->board[i] = value;
+    }
+}
+
+// random_r con un estado de 128 bytes da la misma secuencia que srand(seed) + rand() de glibc,
+// sin el estado global; cada celda depende de la anterior, así que es un único recorrido.
+// glibc usa el estado como int32_t, así que se declara de ese tipo para que quede alineado
+static void init_board_rand(game_t *g, unsigned seed) {
+    game_state_t *gs = g->state;
+    int32_t rng_state[32];
+    struct random_data rng = {0};
+    initstate_r(seed, (char *)rng_state, sizeof rng_state, &rng);
+    for(int y=0;y<gs->board_height;y++)
+        for(int x=0;x<gs->board_width;x++) {
+            int32_t r;
+            random_r(&rng, &r);
+            set_cell(g, idx(x,y,gs->board_width), (r%(MAX_REWARD-MIN_REWARD+1))+MIN_REWARD);
+        }
+}
+
+// Generador por contador: la recompensa de una celda es un hash (finalizador de SplitMix64)
+// de la semilla y el índice, así que no hay estado que pasar de una celda a la siguiente
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static inline int counter_reward(uint64_t key, unsigned cell) {
+    uint64_t z = mix64(key + ((uint64_t)cell + 1) * 0x9e3779b97f4a7c15ull);
+    // Los 32 bits altos escalados a [0, rango): sin el sesgo de un módulo sobre pocos bits
+    return (int)(((z >> 32) * (MAX_REWARD - MIN_REWARD + 1)) >> 32) + MIN_REWARD;
+}
+
+// Celdas por thread como mínimo; los bloques son múltiplos de 64 celdas para que dos threads
+// nunca escriban la misma palabra del bitmap de libres del formato compacto
+#define GEN_MIN_CELLS_PER_THREAD (1u << 18)
+#define GEN_MAX_THREADS 16
+
+typedef struct {
+    game_t *g;
+    uint64_t key;
+    unsigned from, to;
+} gen_chunk_t;
+
+static void *fill_chunk(void *arg) {
+    gen_chunk_t *c = arg;
+    for (unsigned i = c->from; i < c->to; i++)
+        set_cell(c->g, (int)i, counter_reward(c->key, i));
+    return NULL;
+}
+
+static void init_board_counter(game_t *g, unsigned seed) {
+    game_state_t *gs = g->state;
+    unsigned cells = (unsigned)gs->board_width * gs->board_height;
+    uint64_t key = mix64(seed);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned threads = cells / GEN_MIN_CELLS_PER_THREAD;
+    if (cpus > 0 && threads > (unsigned)cpus)
+        threads = (unsigned)cpus;
+    if (threads > GEN_MAX_THREADS)
+        threads = GEN_MAX_THREADS;
+    if (threads < 2) {
+        gen_chunk_t all = { g, key, 0, cells };
+        fill_chunk(&all);
+        return;
+    }
+
+    gen_chunk_t chunks[GEN_MAX_THREADS];
+    pthread_t tids[GEN_MAX_THREADS];
+    unsigned per = ((cells / threads) + 63) & ~63u;
+    unsigned started = 0;
+    for (unsigned t = 0; t < threads; t++) {
+        unsigned from = t * per, to = from + per;
+        chunks[t] = (gen_chunk_t){ g, key, from < cells ? from : cells, to < cells && t + 1 < threads ? to : cells };
+        // El primer bloque lo llena este thread; si no se puede crear uno, su bloque también
+        if (t == 0 || pthread_create(&tids[t], NULL, fill_chunk, &chunks[t]) != 0)
+            continue;
+        started |= 1u << t;
+    }
+    for (unsigned t = 0; t < threads; t++)
+        if (!(started & (1u << t)))
+            fill_chunk(&chunks[t]);
+    for (unsigned t = 1; t < threads; t++)
+        if (started & (1u << t))
+            pthread_join(tids[t], NULL);
+}
+
+void init_board(game_t *g, unsigned seed, board_gen_t gen) {
+    if (gen == BOARD_GEN_RAND)
+        init_board_rand(g, seed);
+    else
+        init_board_counter(g, seed);
+}
+
+// Hasta MAX_PLAYERS se mantiene la ubicación de siempre (en dos filas); con más jugadores
+// esas filas se llenan, así que se reparten en una grilla que cubre todo el tablero
+static void start_position(int i, int P, int W, int H, int *x, int *y) {
+    if (P <= MAX_PLAYERS) {
+        *x = (i+1)*W/(P+1);
+        *y = (i%2? H/3 : (2*H)/3);
+        return;
+    }
+    int rows = 1;
+    while (rows * rows * W < P * H)
+        rows++;
+    int cols = (P + rows - 1) / rows;
+    *x = (2*(i % cols) + 1) * W / (2*cols);
+    *y = (2*(i / cols) + 1) * H / (2*rows);
+}
+
+void block_player(game_t *g, unsigned i) {
+    player_t *p = game_player(g->state, g->extra_players, i);
+    if (!p->is_blocked) {
+        p->is_blocked = true;
+        g->num_blocked++;
+    }
+}
+
+static bool player_stuck(const game_t *g, unsigned i) {
+    const player_t *p = game_player(g->state, g->extra_players, i);
+    return g->free_neighbors[idx(p->x, p->y, g->state->board_width)] == 0;
+}
+
+// Captura una celda libre: cada vecina pierde una libre, y si alguna se queda sin libres y es
+// la posición actual de su dueño, ese jugador ya no tiene movimientos
+static void capture_cell(game_t *g, int cell, int player) {
+    bool was_free = cell_is_free(board_get(g->state, g->format, cell));
+    set_cell(g, cell, player_to_cell_value(player));
+    if (!g->free_neighbors || !was_free)
+        return;
+    int W = g->state->board_width, H = g->state->board_height;
+    int x = cell % W, y = cell / W;
+    for (direction_t d = 0; d < NUM_DIRECTIONS; d++) {
+        int dx, dy;
+        get_direction_offset(d, &dx, &dy);
+        if (!is_inside(x + dx, y + dy, W, H))
+            continue;
+        int n = idx(x + dx, y + dy, W);
+        if (--g->free_neighbors[n] > 0)
+            continue;
+        int owner = get_cell_owner(board_get(g->state, g->format, n));
+        if (owner < 0 || (unsigned)owner >= g->state->num_players)
+            continue;
+        const player_t *p = game_player(g->state, g->extra_players, (unsigned)owner);
+        if (idx(p->x, p->y, W) == n)
+            block_player(g, (unsigned)owner);
+    }
+}
+
+void place_player_at(game_t *g, int i, int x, int y){
+    game_state_t *gs = g->state;
+    int W=gs->board_width, H=gs->board_height;
+    player_t *p = game_player(gs, g->extra_players, (unsigned)i);
+    p->x = (unsigned short)clamp(x,0,W-1);
+    p->y = (unsigned short)clamp(y,0,H-1);
+    p->score=0;
+    p->valid_moves=0;
+    p->invalid_moves=0;
+    p->is_blocked=false;
+    snprintf(p->name, MAX_NAME_LEN, "P%d", i);
+    capture_cell(g, idx(p->x, p->y, W), i);
+}
+
+void place_players(game_t *g){
+    game_state_t *gs = g->state;
+    int W=gs->board_width, H=gs->board_height, P=(int)gs->num_players;
+    for(int i=0;i<P;i++){
+        int x, y;
+        start_position(i, P, W, H, &x, &y);
+        place_player_at(g, i, x, y);
+    }
+}
+
+int apply_move(game_t *g, int pid_idx, unsigned char dir){
+    game_state_t *gs = g->state;
+    player_t *p = game_player(gs, g->extra_players, (unsigned)pid_idx);
+    if(!is_valid_direction(dir)){
+        p->invalid_moves++;
+        return 0;
+    }
+    int dx,dy;
+    get_direction_offset((direction_t)dir, &dx, &dy);
+    int W=gs->board_width, H=gs->board_height;
+    int nx = (int)p->x + dx;
+    int ny = (int)p->y + dy;
+    if (!is_inside(nx,ny,W,H)) {
+        p->invalid_moves++;
+        return 0;
+    }
+
+    int cell_idx = idx(nx,ny,W);
+    int cell = board_get(gs, g->format, cell_idx);
+    if (!cell_is_free(cell)) {
+        p->invalid_moves++;
+        return 0;
+    }
+
+    p->x = (unsigned short)nx;
+    p->y = (unsigned short)ny;
+    p->score += (unsigned)cell;
+    p->valid_moves++;
+    capture_cell(g, cell_idx, pid_idx);
+    publish_delta(g->deltas, cell_idx, player_to_cell_value(pid_idx), pid_idx);
+    if (g->free_neighbors && g->free_neighbors[cell_idx] == 0)
+        block_player(g, (unsigned)pid_idx);
+    return 1;
+}
+
+int game_track_neighbors(game_t *g) {
+    game_state_t *gs = g->state;
+    int W = gs->board_width, H = gs->board_height;
+    g->free_neighbors = malloc((size_t)W * H);
+    if (!g->free_neighbors)
+        return -1;
+    // Primero todas las vecinas dentro del tablero y después se descuentan las ocupadas, que al
+    // empezar la partida son solo las de los jugadores
+    for (int y = 0; y < H; y++) {
+        uint8_t rows = (uint8_t)(1 + (y > 0) + (y < H - 1));
+        uint8_t *row = &g->free_neighbors[idx(0, y, W)];
+        memset(row, 3 * rows - 1, (size_t)W);
+        row[0] = row[W - 1] = (uint8_t)(2 * rows - 1);
+    }
+    for (int i = 0; i < W * H; i++) {
+        if (cell_is_free(board_get(gs, g->format, i)))
+            continue;
+        int x = i % W, y = i / W;
+        for (direction_t d = 0; d < NUM_DIRECTIONS; d++) {
+            int dx, dy;
+            get_direction_offset(d, &dx, &dy);
+            if (is_inside(x + dx, y + dy, W, H))
+                g->free_neighbors[idx(x + dx, y + dy, W)]--;
+        }
+    }
+    for (unsigned i = 0; i < gs->num_players; i++)
+        if (player_stuck(g, i))
+            block_player(g, i);
+    return 0;
+}
+
+void game_untrack_neighbors(game_t *g) {
+    free(g->free_neighbors);
+    g->free_neighbors = NULL;
+}
@@ -0,0 +1,81 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "latency.h"
+
+static const char *stage_names[LAT_STAGES] = { "post", "turn", "lock", "apply", "view", "delay" };
+
+const char *lat_stage_name(lat_stage_t stage) {
+    return stage < LAT_STAGES ? stage_names[stage] : "?";
+}
+
+lat_hist_t *lat_table_create(unsigned num_players) {
+    return calloc((size_t)num_players * LAT_STAGES, sizeof(lat_hist_t));
+}
+
+// Mayor valor que cae en el balde b
+static uint64_t bucket_upper(unsigned b) {
+    if (b < (1u << LAT_SUB_BITS))
+        return b;
+    unsigned shift = (b >> LAT_SUB_BITS) - 1;
+    uint64_t mantissa = (1u << LAT_SUB_BITS) + (b & ((1u << LAT_SUB_BITS) - 1));
+    return ((mantissa + 1) << shift) - 1;
+}
+
+uint64_t lat_hist_percentile(const lat_hist_t *h, double p) {
+    if (h->count == 0)
+        return 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)h->count + 0.999999);
+    if (rank == 0)
+        rank = 1;
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < LAT_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank) {
+            uint64_t v = bucket_upper(b);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+static void merge(lat_hist_t *into, const lat_hist_t *h) {
+    for (unsigned b = 0; b < LAT_BUCKETS; b++)
+        into->buckets[b] += h->buckets[b];
+    into->count += h->count;
+    if (h->max > into->max)
+        into->max = h->max;
+}
+
+static void print_line(FILE *out, const char *who, lat_stage_t stage, const lat_hist_t *h) {
+    fprintf(out, "%-10s %-6s %10llu %12llu %12llu %12llu %12llu\n", who, lat_stage_name(stage),
+            (unsigned long long)h->count, (unsigned long long)lat_hist_percentile(h, 50),
+            (unsigned long long)lat_hist_percentile(h, 99), (unsigned long long)lat_hist_percentile(h, 99.9),
+            (unsigned long long)h->max);
+}
+
+void lat_table_print(FILE *out, const lat_hist_t *table, unsigned num_players) {
+    lat_hist_t *all = calloc(LAT_STAGES, sizeof(lat_hist_t));
+    fprintf(out, "%-10s %-6s %10s %12s %12s %12s %12s\n", "latency", "stage", "count", "p50 ns", "p99 ns", "p999 ns", "max ns");
+    for (unsigned i = 0; i < num_players; i++) {
+        char who[24];
+        snprintf(who, sizeof(who), "player %u", i);
+        for (lat_stage_t s = 0; s < LAT_STAGES; s++) {
+            const lat_hist_t *h = &table[(size_t)i * LAT_STAGES + s];
+            if (h->count == 0)
+                continue;
+            print_line(out, who, s, h);
+            if (all)
+                merge(&all[s], h);
+        }
+    }
+    for (lat_stage_t s = 0; all && s < LAT_STAGES; s++)
+        if (all[s].count > 0)
+            print_line(out, "all", s, &all[s]);
+    free(all);
+}
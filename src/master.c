@@ -7,39 +7,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
 #include <unistd.h>
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
 #include <sys/wait.h>
-#include <sys/select.h>
-#include <signal.h>
-#include <errno.h>
-#include <string.h>
 
 #include "common.h"
-#include "shm.h"
-#include "reader_sync.h"
-#include "writer_sync.h"
-
-typedef struct {
-    int board_width;
-    int board_height;
-    int delay_ms;
-    int timeout_s;
-    unsigned seed;
-    const char *view_bin;
-    char* player_bins[MAX_PLAYERS];
-    int num_players;
-} game_args_t;
-
-typedef struct { 
-    int read_fd; // read fd (extremo de lectura del pipe)
-    int write_fd; // write fd (extremo de escritura del pipe)
-    pid_t pid; // pid del proceso hijo
-    int alive; // indica si el proceso hijo está vivo
-} pipe_info_t;
-
+#include "match.h"
 
 static void die(const char *m, int error_code) { 
     puts(m); 
@@ -50,112 +23,42 @@ static int clamp(int v,int lo,int hi) {
     return v < lo ? lo : (v > hi ? hi : v); 
 }
 
-static void init_board(game_state_t *gs, unsigned seed) {
-    srand(seed);
-    for(int y=0;y<gs->board_height;y++)
-        for(int x=0;x<gs->board_width;x++)
-            gs->board[idx(x,y,gs->board_width)] = (rand()%(MAX_REWARD-MIN_REWARD+1))+MIN_REWARD;
-}
+#define MAX_GAMES 1024
 
-static void place_players(game_state_t *gs){
-    int W=gs->board_width, H=gs->board_height, P=(int)gs->num_players;
-    for(int i=0;i<P;i++){
-        int x = (i+1)*W/(P+1);
-        int y = (i%2? H/3 : (2*H)/3);
-        gs->players[i].x = (unsigned short)clamp(x,0,W-1);
-        gs->players[i].y = (unsigned short)clamp(y,0,H-1);
-        gs->players[i].score=0;
-        gs->players[i].valid_moves=0;
-        gs->players[i].invalid_moves=0;
-        gs->players[i].is_blocked=false;
-        snprintf(gs->players[i].name, MAX_NAME_LEN, "P%d", i);
-        gs->board[idx(gs->players[i].x, gs->players[i].y, W)] = player_to_cell_value(i);
-    }
-}
-
-static int apply_move(game_state_t * gs, int pid_idx, unsigned char dir){
-    if(!is_valid_direction(dir)){ 
-        gs->players[pid_idx].invalid_moves++; 
-        return 0; 
-    }
-    int dx,dy; 
-    get_direction_offset((direction_t)dir, &dx, &dy);
-    int W=gs->board_width, H=gs->board_height;
-    int nx = (int)gs->players[pid_idx].x + dx;
-    int ny = (int)gs->players[pid_idx].y + dy;
-    if (!is_inside(nx,ny,W,H)) { 
-        gs->players[pid_idx].invalid_moves++; 
-        return 0; 
-    }
-
-    int *cell = &gs->board[idx(nx,ny,W)];
-    if (!cell_is_free(*cell)) { 
-        gs->players[pid_idx].invalid_moves++; 
-        return 0; 
-    }
-
-    gs->players[pid_idx].x = (unsigned short)nx;
-    gs->players[pid_idx].y = (unsigned short)ny;
-    gs->players[pid_idx].score += (unsigned)*cell;
-    gs->players[pid_idx].valid_moves++;
-    *cell = player_to_cell_value(pid_idx);
-    return 1;
-}
-
-// static bool has_valid_neighbor_at_locked(const game_state_t *gs, int x, int y){
-//     int W = (int)gs->board_width;
-//     int H = (int)gs->board_height;
-//     for (direction_t d = 0; d < NUM_DIRECTIONS; d++){
-//         int dx, dy; 
-//         get_direction_offset(d, &dx, &dy);
-//         int nx = x + dx, ny = y + dy;
-//         if (is_inside(nx, ny, W, H)){
-//             if (gs->board[idx(nx, ny, W)] > 0)
-//                 return true;
-//         }
-//     }
-//     return false;
-// }
-
-static void exec_with_board_args(const char *bin, int board_width, int board_height, const char *error_msg) {
-    char wb[16], hb[16];
-    snprintf(wb, sizeof wb, "%d", board_width);
-    snprintf(hb, sizeof hb, "%d", board_height);
-    execl(bin, bin, wb, hb, (char*)NULL);
-    perror(error_msg);
-    _exit(EXEC_ERROR_CODE);
-}
-
-static void finish(game_sync_t * sync, game_state_t * gs, const char * view_bin, pipe_info_t *pipes) {
-    // printf("DEBUG: Game finishing, killing remaining processes...\n");
-    writer_enter(sync);
-    gs->game_finished = true;
-    writer_exit(sync);
-    
-    // Terminar todos los procesos hijos que sigan vivos con SIGKILL directamente
-    // esto lo agregue porque sino el /bin/yes no termina y el master se queda bloqueado en el wait
-    for (unsigned i = 0; i < gs->num_players; ++i) {
-        if (pipes[i].alive && pipes[i].pid > 0) {
-            // printf("Killing player %u (pid=%d) with SIGKILL\n", i, pipes[i].pid);
-            kill(pipes[i].pid, SIGKILL);
-        }
-        sem_post(&sync->player_ready[i]);
-    }
-    if (view_bin) {
-        sem_post(&sync->view_ready);
-        sem_wait(&sync->view_done);
-    }
-}
+// Una de las partidas de -n, cada una en su thread y con sus propias regiones
+typedef struct {
+    game_args_t args;
+    char state_name[64], sync_name[64], moves_name[64], stats_name[64];
+    char *record_path;
+    game_result_t result;
+    int rc;
+} hosted_game_t;
 
-static game_args_t parse_args(int argc, char **argv) {
+static game_args_t parse_args(int argc, char **argv, int *num_games) {
     game_args_t args;
     args.board_width = MIN_BOARD_SIZE;
     args.board_height = MIN_BOARD_SIZE;
     args.delay_ms = DEFAULT_DELAY_MS;
     args.timeout_s = DEFAULT_TIMEOUT_S;
+    args.turn_ms = 0;
     args.seed = (unsigned)time(NULL);
     args.view_bin = NULL;
+    args.view_fps = 0;
     args.num_players = 0;
+    args.shm_state = NULL;
+    args.shm_sync = NULL;
+    args.shm_moves = NULL;
+    args.shm_stats = NULL;
+    args.read_protocol = READ_PROTOCOL_SEQLOCK;
+    args.state_map_opts = 0;
+    args.board_format = BOARD_FORMAT_INT;
+    args.board_gen = BOARD_GEN_COUNTER;
+    args.batch_moves = false;
+    args.move_transport = MOVE_TRANSPORT_PIPE;
+    args.record_path = NULL;
+    args.early_finish = false;
+    args.pool = NULL;
+    args.plugins = NULL;
 
     for (int i = 1; i < argc; i++) {
         if (!strcmp(argv[i], "-w") && argc > i + 1) {
@@ -178,37 +81,121 @@ static game_args_t parse_args(int argc, char **argv) {
             args.delay_ms = atoi(argv[++i]);
         else if (!strcmp(argv[i], "-t") && argc > i + 1)
             args.timeout_s = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-T") && argc > i + 1) {
+            args.turn_ms = atoi(argv[++i]);
+            if (args.turn_ms < 1)
+                die("Invalid turn deadline", ERROR_INVALID_ARGS);
+        }
         else if (!strcmp(argv[i], "-s") && argc > i + 1)
             args.seed = (unsigned)atoi(argv[++i]);
         else if (!strcmp(argv[i], "-v") && argc > i + 1)
             args.view_bin = argv[++i];
+        else if (!strcmp(argv[i], "-l") && argc > i + 1) {
+            int protocol = parse_read_protocol(argv[++i]);
+            if (protocol < 0)
+                die("Invalid read protocol (use rw or seqlock)", ERROR_INVALID_ARGS);
+            args.read_protocol = (read_protocol_t)protocol;
+        }
+        else if (!strcmp(argv[i], "-c"))
+            args.board_format = BOARD_FORMAT_COMPACT;
+        else if (!strcmp(argv[i], "-f") && argc > i + 1) {
+            args.view_fps = atoi(argv[++i]);
+            if (args.view_fps < 1)
+                die("Invalid view frame rate", ERROR_INVALID_ARGS);
+        }
+        else if (!strcmp(argv[i], "-g") && argc > i + 1) {
+            int gen = parse_board_gen(argv[++i]);
+            if (gen < 0)
+                die("Invalid board generator (use rand or counter)", ERROR_INVALID_ARGS);
+            args.board_gen = (board_gen_t)gen;
+        }
+        else if (!strcmp(argv[i], "-n") && argc > i + 1) {
+            *num_games = atoi(argv[++i]);
+            if (*num_games < 1 || *num_games > MAX_GAMES)
+                die("Invalid number of games", ERROR_INVALID_ARGS);
+        }
+        else if (!strcmp(argv[i], "-e"))
+            args.early_finish = true;
+        else if (!strcmp(argv[i], "-b"))
+            args.batch_moves = true;
+        else if (!strcmp(argv[i], "-r") && argc > i + 1)
+            args.record_path = argv[++i];
+        else if (!strcmp(argv[i], "-x") && argc > i + 1) {
+            int transport = parse_move_transport(argv[++i]);
+            if (transport < 0)
+                die("Invalid move transport (use pipe or ring)", ERROR_INVALID_ARGS);
+            args.move_transport = (move_transport_t)transport;
+        }
+        else if (!strcmp(argv[i], "-m") && argc > i + 1) {
+            int opts = parse_map_opts(argv[++i]);
+            if (opts < 0)
+                die("Invalid map options (use huge,prefault,lock)", ERROR_INVALID_ARGS);
+            args.state_map_opts = (unsigned)opts;
+        }
         else if (!strcmp(argv[i], "-p")) {
-            while (argc > i + 1 && args.num_players < MAX_PLAYERS && argv[i + 1][0] != '-')
-                args.player_bins[args.num_players++] = argv[++i];
+            args.player_bins = &argv[i + 1];
+            args.num_players = 0;
+            while (argc > i + 1 && args.num_players < MAX_PLAYERS_EXT && argv[i + 1][0] != '-') {
+                args.num_players++;
+                i++;
+            }
         }
         else {
-            die("Usage: ./master [-w width] [-h height] [-d delay] [-s seed] [-v view] [-t timeout] -p player1 player2...", ERROR_INVALID_ARGS);
+            die("Usage: ./master [-w width] [-h height] [-d delay] [-s seed] [-v view] [-f fps] [-t timeout] [-T turn_ms] [-l rw|seqlock] [-m huge,prefault,lock] [-c] [-g rand|counter] [-b] [-e] [-n games] [-x pipe|ring] [-r record] -p player1 player2...", ERROR_INVALID_ARGS);
         }
     }
     return args;
 }
 
-static void validate_game_args(int *board_width, int *board_height, int num_players) {
-    *board_width = clamp(*board_width, MIN_BOARD_SIZE, MAX_BOARD_SIZE);
-    *board_height = clamp(*board_height, MIN_BOARD_SIZE, MAX_BOARD_SIZE);
-    if (num_players < 1) {
+static void validate_game_args(game_args_t *args, int num_games) {
+    args->board_width = clamp(args->board_width, MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+    args->board_height = clamp(args->board_height, MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+    if (args->num_players < 1) {
         die("Error: At least one player must be specified using -p", ERROR_INVALID_ARGS);
     }
+    // Cada jugador necesita su lugar de partida en la grilla (ver place_players)
+    if (args->num_players > MAX_PLAYERS && (long)args->num_players * 4 > (long)args->board_width * args->board_height) {
+        die("Error: Board too small for that many players", ERROR_INVALID_ARGS);
+    }
+    if (args->board_format == BOARD_FORMAT_COMPACT && args->num_players > MAX_COMPACT_PLAYERS) {
+        die("Error: The compact board format supports up to 129 players", ERROR_INVALID_ARGS);
+    }
+    if (num_games > 1 && args->view_bin) {
+        die("Error: The view can only be used with a single game", ERROR_INVALID_ARGS);
+    }
+    // Jugadores .so: se juega en este proceso, sin memoria compartida que la vista pueda mirar
+    int loaded = plugins_load(args->player_bins, (unsigned)args->num_players, &args->plugins);
+    if (loaded < 0)
+        die("Error: could not load the player plugins", ERROR_INVALID_ARGS);
+    if (loaded && (args->view_bin || args->board_format == BOARD_FORMAT_COMPACT))
+        die("Error: Plugins play without view and on the int board format", ERROR_INVALID_ARGS);
 }
 
-static void print_game_args(const game_args_t *args) {
+static void print_game_args(const game_args_t *args, int num_games) {
     system("clear");
     printf("width: %d\n", args->board_width);
     printf("height: %d\n", args->board_height);
     printf("delay: %d\n", args->delay_ms);
     printf("timeout: %d\n", args->timeout_s);
+    if (args->turn_ms > 0)
+        printf("turn deadline: %d ms\n", args->turn_ms);
     printf("seed: %u\n", args->seed);
     printf("view: %s\n", args->view_bin ? args->view_bin : "(none)");
+    if (args->view_fps > 0)
+        printf("view fps: %d (async)\n", args->view_fps);
+    printf("read protocol: %s\n", args->read_protocol == READ_PROTOCOL_SEQLOCK ? "seqlock" : "rw");
+    printf("board format: %s\n", args->board_format == BOARD_FORMAT_COMPACT ? "compact" : "int");
+    printf("board generator: %s\n", args->board_gen == BOARD_GEN_RAND ? "rand" : "counter");
+    printf("batch moves: %s\n", args->batch_moves ? "yes" : "no");
+    printf("early finish: %s\n", args->early_finish ? "yes" : "no");
+    if (args->record_path)
+        printf("record: %s\n", args->record_path);
+    if (args->plugins)
+        printf("players: in-process plugins\n");
+    else
+        printf("move transport: %s\n", args->move_transport == MOVE_TRANSPORT_RING ? "ring" : "pipe");
+    if (num_games > 1)
+        printf("games: %d (seeds %u..%u)\n", num_games, args->seed, args->seed + (unsigned)num_games - 1);
     printf("num_players: %d\n", args->num_players);
     for (int i = 0; i < args->num_players; i++) {
         printf("  %s\n", args->player_bins[i]);
@@ -218,287 +205,134 @@ static void print_game_args(const game_args_t *args) {
     system("clear");
 }
 
-
-
-
-int main(int argc, char **argv){
-    game_args_t args = parse_args(argc, argv);
-    int board_width = args.board_width;
-    int board_height = args.board_height;
-    int delay_ms = args.delay_ms;
-    int timeout_s = args.timeout_s;
-    unsigned seed = args.seed;
-    const char *view_bin = args.view_bin;
-    char **player_bins = args.player_bins;
-    int num_players = args.num_players;
-
-    validate_game_args(&board_width, &board_height, num_players);
-
-    print_game_args(&args);
-    
-    shm_adt game_state_shm, game_sync_shm;
-    if (shm_region_open(&game_state_shm, SHM_STATE, game_state_size(board_width,board_height)) == -1) 
-        die("Error: failed to open or create shared memory region for game state", ERROR_SHM);
-    if (shm_region_open(&game_sync_shm,  SHM_SYNC, sizeof(game_sync_t)) == -1) 
-        die("Error: failed to open or create shared memory region for game sync", ERROR_SHM);
-
-    game_state_t *gs=NULL; 
-    game_sync_t *sync=NULL;
-    if (game_state_map(game_state_shm, (unsigned short)board_width, (unsigned short)board_height, &gs) == -1) 
-        die("Error: failed to map game state shared memory", ERROR_SHM);
-    if (game_sync_map(game_sync_shm, &sync) == -1) 
-        die("Error: failed to map game sync shared memory", ERROR_SHM);
-
-    writer_enter(sync);
-    gs->board_width = (unsigned short) board_width;
-    gs->board_height = (unsigned short) board_height;
-    gs->num_players = (unsigned) num_players;
-    gs->game_finished = false;
-    init_board(gs, seed);
-    place_players(gs);
-    writer_exit(sync);
-
-    pid_t view_pid = -1; 
-    if (view_bin){ 
-        view_pid = fork();
-        if (view_pid<0) 
-            die("Error: could not fork view process", ERROR_FORK);
-        if (view_pid == 0){ 
-            exec_with_board_args(view_bin, board_width, board_height, "Error: failed to exec player");
-        } 
-    }
-
-    pipe_info_t pipes[MAX_PLAYERS] = {0};
-    for (int i=0;i<num_players;i++){
-        int fds[2]; 
-        if (pipe(fds)==-1) 
-            die("Error: could not create pipe for player process", ERROR_PIPE);
-        pipes[i].read_fd = fds[0]; 
-        pipes[i].write_fd = fds[1]; 
-        pipes[i].alive=1;
-        fcntl(pipes[i].read_fd, F_SETFL, O_NONBLOCK); 
-
-        pid_t pid = fork();
-        if (pid < 0) 
-            die("Error: could not fork player process", ERROR_FORK);
-        if (pid == 0) { 
-            for (int j = 0; j < i; j++) { //  cerrar todos los pipes de los hijos
-                close(pipes[j].read_fd);
-            }
-            dup2(pipes[i].write_fd, 1); 
-            close(pipes[i].read_fd);  
-            close(pipes[i].write_fd); 
-            exec_with_board_args(player_bins[i], board_width, board_height, "Error: failed to exec player");
-        } else { 
-            close(pipes[i].write_fd);
-            pipes[i].pid = pid;
-            writer_enter(sync);
-            gs->players[i].pid = pid; 
-            const char *bn = player_bins[i];
-            const char *slash = strrchr(bn, '/');
-            const char *pname = slash ? slash + 1 : bn;
-            snprintf(gs->players[i].name, MAX_NAME_LEN, "%s", pname);
-            writer_exit(sync);
-        }
+static void print_players(const game_result_t *result) {
+    for (unsigned i = 0; i < result->num_players; i++) {
+        const player_t *p = &result->players[i];
+        printf("Player %s (%u) exited (%d) with a score of %u / %u / %u\n",
+               p->name, i, result->exit_codes[i], p->score, p->valid_moves, p->invalid_moves);
     }
+}
 
+static void *hosted_game_run(void *arg) {
+    hosted_game_t *h = arg;
+    h->rc = run_game(&h->args, &h->result);
+    return NULL;
+}
 
-    
-
-    for (unsigned i=0; i<gs->num_players; i++)
-        sem_post(&sync->player_ready[i]);
-
-    if (view_bin){ 
-        sem_post(&sync->view_ready); 
-        sem_wait(&sync->view_done);
+// -n: las partidas corren a la vez, una por thread, con regiones /chomp_<pid>_g<k>_* en lugar de
+// las de siempre (cada jugador y vista recibe los nombres en CHOMP_SHM_*) y semillas seed..seed+n-1
+static int run_games(const game_args_t *args, int num_games) {
+    hosted_game_t *games = calloc((size_t)num_games, sizeof(*games));
+    pthread_t *tids = calloc((size_t)num_games, sizeof(*tids));
+    if (!games || !tids) {
+        free(games);
+        free(tids);
+        perror("Error: could not allocate games");
+        return ERROR_SHM;
     }
-
-    struct timespec last_valid;  
-    clock_gettime(CLOCK_MONOTONIC, &last_valid);
-    unsigned next_idx = 0; 
-
-    while (1) {
-        struct timespec now;
-        clock_gettime(CLOCK_MONOTONIC, &now);
-
-        time_t elapsed = now.tv_sec - last_valid.tv_sec;
-        if (elapsed >= timeout_s) {
-            finish(sync, gs, view_bin, pipes);
-            break; 
-        }
-        time_t remain = timeout_s - elapsed;
-
-        bool to_block[MAX_PLAYERS] = {0};
-        int fds_to_close[MAX_PLAYERS];
-        for (unsigned i=0;i<MAX_PLAYERS;i++) fds_to_close[i] = -1;
-
-        reader_enter(sync);
-        for (unsigned i = 0; i < gs->num_players; i++){
-            if (gs->players[i].is_blocked) 
-                continue;
-            // int x = (int)gs->players[i].x;
-            // int y = (int)gs->players[i].y;
-        }
-        reader_exit(sync);
-
-        bool any_blocked_now = false;
-        for (unsigned i = 0; i < gs->num_players; i++){
-            if (!to_block[i]) 
-                continue;
-            writer_enter(sync);
-            gs->players[i].is_blocked = true;
-            writer_exit(sync);
-            if (fds_to_close[i] >= 0){ 
-                close(fds_to_close[i]);
-                pipes[i].read_fd = -1; 
-            }
-            any_blocked_now = true;
-        }
-        if (any_blocked_now && view_bin){
-            sem_post(&sync->view_ready);
-            sem_wait(&sync->view_done);
-        }
-
-        fd_set rfds;
-        FD_ZERO(&rfds);
-        int maxfd = -1;
-        unsigned active_cnt = 0;
-
- 
-        bool blocked[MAX_PLAYERS];
-        reader_enter(sync);
-        for (unsigned i = 0; i < gs->num_players; i++)
-            blocked[i] = gs->players[i].is_blocked;
-        reader_exit(sync);
-
-        for (unsigned i = 0; i < gs->num_players; i++) {
-            if (!blocked[i] && pipes[i].read_fd >= 0) {
-                FD_SET(pipes[i].read_fd, &rfds);
-                if (pipes[i].read_fd > maxfd) 
-                    maxfd = pipes[i].read_fd;
-                active_cnt++;
-            }
-        }
-
-        if (active_cnt == 0) {
-            finish(sync, gs, view_bin, pipes);
-            break; 
-        }
-
-        struct timeval tv;
-        tv.tv_sec  = remain;
-        tv.tv_usec = 0;
-
-        int ready = select(maxfd + 1, &rfds, NULL, NULL, &tv);
-        if (ready < 0) {
-            if (errno == EINTR) 
-                continue; 
-            die("Error: select() failed while waiting for player input", ERROR_SELECT);
+    // Un pipe por jugador de cada partida, todos en el mismo proceso
+    ensure_fd_limit((unsigned)(args->num_players * num_games));
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int started = 0;
+    for (int k = 0; k < num_games; k++) {
+        hosted_game_t *h = &games[k];
+        h->args = *args;
+        h->args.seed = args->seed + (unsigned)k;
+        snprintf(h->state_name, sizeof h->state_name, "/chomp_%d_g%d_state", (int)getpid(), k);
+        snprintf(h->sync_name, sizeof h->sync_name, "/chomp_%d_g%d_sync", (int)getpid(), k);
+        snprintf(h->moves_name, sizeof h->moves_name, "/chomp_%d_g%d_moves", (int)getpid(), k);
+        snprintf(h->stats_name, sizeof h->stats_name, "/chomp_%d_g%d_stats", (int)getpid(), k);
+        h->args.shm_state = h->state_name;
+        h->args.shm_sync = h->sync_name;
+        h->args.shm_moves = h->moves_name;
+        h->args.shm_stats = h->stats_name;
+        if (args->record_path) {
+            size_t len = strlen(args->record_path) + 16;
+            h->record_path = malloc(len);
+            if (h->record_path)
+                snprintf(h->record_path, len, "%s.%d", args->record_path, k);
+            h->args.record_path = h->record_path;
         }
-        if (ready == 0) {
-            finish(sync, gs, view_bin, pipes);
+        h->rc = ERROR_FORK;
+        if (pthread_create(&tids[k], NULL, hosted_game_run, h) != 0) {
+            perror("Error: could not start game thread");
             break;
         }
+        started++;
+    }
+    for (int k = 0; k < started; k++)
+        pthread_join(tids[k], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    int failed = 0;
+    for (int k = 0; k < num_games; k++) {
+        hosted_game_t *h = &games[k];
+        if (k < started && h->rc == SUCCESS) {
+            printf("Game %d (seed %u): %ld us%s\n", k, h->args.seed, h->result.duration_us,
+                   h->result.decided ? ", finished early" : "");
+            print_players(&h->result);
+        } else {
+            printf("Game %d (seed %u): failed (%d)\n", k, h->args.seed, h->rc);
+            failed++;
+        }
+        if (k < started)
+            game_result_free(&h->result);
+        free(h->record_path);
+    }
+    double secs = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Games: %d  failed: %d  time: %.3f s  games/sec: %.1f\n", started, failed, secs,
+           secs > 0 ? (double)(started - failed) / secs : 0.0);
+    free(games);
+    free(tids);
+    return failed == 0 && started == num_games ? SUCCESS : ERROR_FORK;
+}
 
-        for (unsigned step = 0; step < gs->num_players; step++) {
-            unsigned i = (next_idx + step) % gs->num_players;
-            int fd = pipes[i].read_fd;
-            if (fd < 0 || blocked[i]) 
-                continue;
-            if (!FD_ISSET(fd, &rfds)) 
-                continue;  
-
-            unsigned char dir;
-            ssize_t n = read(fd, &dir, 1);
-            if (n == 0) {
-                writer_enter(sync);
-                gs->players[i].is_blocked = true;
-                writer_exit(sync);
-                close(fd);
-                pipes[i].read_fd = -1;
-                pipes[i].alive = 0;
-                continue;
-            } else if (n < 0) {
-                if (errno == EAGAIN) 
-                    continue;   
-                writer_enter(sync);
-                gs->players[i].is_blocked = true;
-                writer_exit(sync);
-                close(fd);
-                pipes[i].read_fd = -1;
-                pipes[i].alive = 0;
-                continue;
-            }
-
-            int was_valid;
-            unsigned int invalid_before, invalid_after;
-            writer_enter(sync);
-            invalid_before = gs->players[i].invalid_moves;
-            was_valid = apply_move(gs, (int)i, dir);
-            invalid_after = gs->players[i].invalid_moves;
-            writer_exit(sync);
-
-            if (was_valid) 
-                clock_gettime(CLOCK_MONOTONIC, &last_valid);
-
-            // Actualizar la vista también cuando aumentan los movimientos inválidos
-            if ((was_valid || invalid_after != invalid_before) && view_bin) {
-                sem_post(&sync->view_ready);
-                sem_wait(&sync->view_done);
-            }
-
-            if (was_valid && delay_ms > 0) {
-                struct timespec ts = { .tv_sec = delay_ms/1000,
-                                    .tv_nsec = (delay_ms%1000)*1000000L };
-                nanosleep(&ts, NULL);
-            }
+int main(int argc, char **argv){
+    int num_games = 1;
+    game_args_t args = parse_args(argc, argv, &num_games);
+    validate_game_args(&args, num_games);
+
+    print_game_args(&args, num_games);
+    if (num_games > 1) {
+        int rc = run_games(&args, num_games);
+        plugins_unload(args.plugins, (unsigned)args.num_players);
+        return rc;
+    }
 
-            sem_post(&sync->player_ready[i]);
-        }
-        next_idx = (next_idx + 1) % gs->num_players;
+    game_result_t result;
+    bool in_process = args.plugins != NULL;
+    int rc = run_game(&args, &result);
+    plugins_unload(args.plugins, (unsigned)args.num_players);
+    if (rc != SUCCESS) {
+        game_result_free(&result);
+        return rc;
     }
-    
-    
-    int status;
 
-    if (view_pid>0) {
-        waitpid(view_pid,&status,0); 
+    int status = result.view_status;
+    if (status != -1) {
         if (WIFEXITED(status)) {
             printf("view exited (%d)\n", WEXITSTATUS(status));
         } else if (WIFSIGNALED(status)) {
             printf("view signal=%d\n", WTERMSIG(status));
         }
-    }    
-    
-    for (unsigned i=0;i<gs->num_players;i++){
-        int code = -1;
-        if (pipes[i].pid>0) {
-            // SIGKILL y waitpid bloqueante - debería ser inmediato
-            // kill(pipes[i].pid, SIGKILL);
-            waitpid(pipes[i].pid, &status, 0);
-            if (WIFEXITED(status)) code = WEXITSTATUS(status);
-            else if (WIFSIGNALED(status)) code = WTERMSIG(status);
-        }
-        unsigned score, vld, inv;
-        char namebuf[MAX_NAME_LEN];
-        reader_enter(sync);
-        score = gs->players[i].score;
-        vld = gs->players[i].valid_moves;
-        inv = gs->players[i].invalid_moves;
-        snprintf(namebuf, sizeof namebuf, "%s", gs->players[i].name);
-        reader_exit(sync);
-
-        printf("Player %s (%u) exited (%d) with a score of %u / %u / %u\n",
-               namebuf, i, code, score, vld, inv);
-        if (pipes[i].read_fd >= 0) {
-            close(pipes[i].read_fd);
-            pipes[i].read_fd = -1;
-        }
     }
-    
-    game_state_unmap_destroy(game_state_shm);
-    game_sync_unmap_destroy(game_sync_shm);
+
+    print_players(&result);
+    printf("State region: %zu bytes, map %ld us (%ld faults), init_board %ld us (%ld faults)\n",
+           result.state_bytes, result.map_us, result.map_faults, result.init_us, result.init_faults);
+    printf("Moves: %lu applied with %lu writer locks (%.2f per lock)\n", result.moves_applied, result.move_locks,
+           result.move_locks ? (double)result.moves_applied / (double)result.move_locks : 0.0);
+    printf("Game duration: %ld us\n", result.duration_us);
+    if (result.decided)
+        printf("Finished early: no player could reach a free reward\n");
+    if (!in_process)
+        printf("Turn round trip: %ld ns average over %lu turns\n", result.turn_rtt_avg_ns, result.turns_timed);
+    if (args.turn_ms > 0)
+        printf("Turns forfeited: %lu (deadline %d ms)\n", result.turns_forfeited, args.turn_ms);
+    if (result.latency)
+        lat_table_print(stdout, result.latency, result.num_players);
+    game_result_free(&result);
     return SUCCESS;
 }
-
-
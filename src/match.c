@@ -0,0 +1,1406 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <signal.h>
+#include <errno.h>
+
+#include "common.h"
+#include "shm.h"
+#include "game.h"
+#include "match.h"
+#include "reader_sync.h"
+#include "writer_sync.h"
+#include "move_ring.h"
+#include "record.h"
+#include "latency.h"
+#include "stats.h"
+#include "reach.h"
+
+extern char **environ;
+
+#define PLAYER_INBUF_SIZE 512  // bytes de cada jugador leídos del pipe y todavía no procesados
+#define EPOLL_EVENTS 256
+#define RING_IDLE_CHECK_MS 100 // con buffers circulares no hay EOF: cada tanto se buscan jugadores muertos
+#define BLOCKED_GRACE_MS 500   // con todos bloqueados, cuánto se espera a que los jugadores se vayan solos
+#define POOL_RELEASE_MS 1000   // cuánto se espera el POOL_GAME_DONE de los jugadores del pool
+
+typedef struct {
+    int read_fd; // read fd (extremo de lectura del pipe)
+    int write_fd; // write fd (extremo de escritura del pipe)
+    pid_t pid; // pid del proceso hijo
+    int alive; // indica si el proceso hijo está vivo
+    unsigned char inbuf[PLAYER_INBUF_SIZE];
+    unsigned in_head, in_count;
+    bool more;   // el último read llenó el buffer: puede quedar algo en el pipe
+    bool eof;    // el jugador cerró su extremo (o falló el read)
+    bool queued; // está en la cola de listos
+    move_ring_t *ring;        // con MOVE_TRANSPORT_RING los movimientos llegan por acá y no por el pipe
+    bool awaiting;            // se le dio el turno y todavía no llegó su movimiento
+    struct timespec posted;   // cuándo se le dio el turno
+    bool blocked_woken;       // ya recibió el último post después de quedar bloqueado
+    unsigned turn_seq;        // turnos dados; invalida los plazos viejos del heap
+    unsigned discard;         // movimientos de turnos perdidos por plazo que todavía van a llegar
+    bool tick_wait;           // ya movió: el próximo turno se le da en el próximo tick
+    struct timespec moved_at; // cuándo se procesó el movimiento que lo dejó esperando el tick
+    game_stats_player_t *stats; // contadores del jugador en la región de estadísticas, NULL si no hay
+} pipe_info_t;
+
+// Plazo de un turno: vence en deadline_ns si el jugador sigue con ese turn_seq sin contestar
+typedef struct {
+    long long deadline_ns;
+    unsigned idx;
+    unsigned seq;
+} turn_deadline_t;
+
+// Estado del master durante una partida
+typedef struct {
+    game_t *game;
+    game_sync_t *sync;
+    pipe_info_t *pipes;
+    unsigned num_players;
+    const char *view_bin;
+    bool view_async;               // la vista dibuja a su ritmo: solo se incrementa view_generation
+    int delay_ms;
+    int timeout_s;
+    unsigned *ready_q;             // cola circular de listos (num_players lugares), sin repetidos
+    unsigned ready_head, ready_count;
+    bool batch_moves;              // aplicar todos los movimientos de una ronda con un solo writer_enter
+    unsigned long moves_applied;   // movimientos aplicados (válidos o no)
+    unsigned long move_locks;      // writer_enter usados para aplicar movimientos
+    move_rings_t *rings;           // NULL con MOVE_TRANSPORT_PIPE
+    recorder_t *rec;               // grabación de la partida, NULL si no se graba
+    unsigned long rtt_count;       // turnos medidos desde el sem_post hasta que llega el movimiento
+    unsigned long long rtt_sum_ns;
+    lat_hist_t *lat;               // histogramas por jugador y etapa, NULL con CHOMP_LATENCY en 0
+    game_stats_t *stats;           // región de estadísticas, NULL si no se pudo crear
+    reach_t *reach;                // componentes de libres con early_finish, NULL si no
+    bool reach_changed;            // hubo capturas (o se fue alguien) desde el último reach_decided
+    bool decided;                  // se terminó porque ningún puntaje podía cambiar
+    player_pool_t *pool;           // jugadores del pool: sus pipes no se cierran y no se los mata
+    int turn_ms;                   // plazo de cada turno, 0 sin plazo
+    turn_deadline_t *deadlines;    // min-heap de plazos de los turnos dados (con entradas viejas)
+    unsigned num_deadlines, cap_deadlines;
+    unsigned long forfeits;        // turnos perdidos por plazo
+    struct timespec next_tick;     // con delay_ms > 0: cuándo se dan los turnos de los que esperan
+    unsigned *tick_list;           // jugadores con tick_wait, en el orden en que movieron
+    unsigned tick_waiting;
+} match_t;
+
+typedef struct {
+    char **envp;       // entorno de los hijos con los nombres de las memorias
+    char *state_kv;    // "CHOMP_SHM_STATE=<nombre>"
+    char *sync_kv;     // "CHOMP_SHM_SYNC=<nombre>"
+    char *moves_kv;    // "CHOMP_SHM_MOVES=<nombre>"
+    char *stats_kv;    // "CHOMP_SHM_STATS=<nombre>"
+} child_env_t;
+
+typedef struct {
+    pid_t pid;         // -1 si hay que lanzarlo antes de la próxima partida
+    int ctl_fd;        // extremo de escritura de su stdin: una línea por partida
+    int move_fd;       // extremo de lectura de su stdout (no bloqueante): movimientos y POOL_GAME_DONE
+} pool_slot_t;
+
+struct player_pool {
+    unsigned num_players;
+    char **bins;
+    char **envp;       // entorno del proceso más CHOMP_POOL=1
+    pool_slot_t *slots;
+};
+
+
+static char *make_kv(const char *key, const char *value) {
+    size_t len = strlen(key) + strlen(value) + 2;
+    char *kv = malloc(len);
+    if (kv)
+        snprintf(kv, len, "%s=%s", key, value);
+    return kv;
+}
+
+static bool has_key(const char *kv, const char *key) {
+    size_t len = strlen(key);
+    return strncmp(kv, key, len) == 0 && kv[len] == '=';
+}
+
+static void child_env_free(child_env_t *env) {
+    free(env->state_kv);
+    free(env->sync_kv);
+    free(env->moves_kv);
+    free(env->stats_kv);
+    free(env->envp);
+}
+
+// Se arma antes de los fork: en el hijo solo se llama a exec
+static int child_env_init(child_env_t *env, const char *state_name, const char *sync_name, const char *moves_name, const char *stats_name) {
+    size_t n = 0;
+    while (environ[n])
+        n++;
+    env->state_kv = make_kv(ENV_SHM_STATE, state_name);
+    env->sync_kv = make_kv(ENV_SHM_SYNC, sync_name);
+    env->moves_kv = make_kv(ENV_SHM_MOVES, moves_name);
+    env->stats_kv = make_kv(ENV_SHM_STATS, stats_name);
+    env->envp = malloc((n + 5) * sizeof(char *));
+    if (!env->state_kv || !env->sync_kv || !env->moves_kv || !env->stats_kv || !env->envp) {
+        child_env_free(env);
+        return -1;
+    }
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!has_key(environ[i], ENV_SHM_STATE) && !has_key(environ[i], ENV_SHM_SYNC) && !has_key(environ[i], ENV_SHM_MOVES) &&
+            !has_key(environ[i], ENV_SHM_STATS))
+            env->envp[k++] = environ[i];
+    }
+    env->envp[k++] = env->state_kv;
+    env->envp[k++] = env->sync_kv;
+    env->envp[k++] = env->moves_kv;
+    env->envp[k++] = env->stats_kv;
+    env->envp[k] = NULL;
+    return 0;
+}
+
+static void exec_with_board_args(const char *bin, int board_width, int board_height, char **envp, const char *error_msg) {
+    char wb[16], hb[16];
+    snprintf(wb, sizeof wb, "%d", board_width);
+    snprintf(hb, sizeof hb, "%d", board_height);
+    execle(bin, bin, wb, hb, (char*)NULL, envp);
+    perror(error_msg);
+    _exit(EXEC_ERROR_CODE);
+}
+
+// Avisa a la vista que el estado cambió; en modo asíncrono nunca espera
+static void notify_view(match_t *m) {
+    if (!m->view_bin)
+        return;
+    if (m->stats)
+        stats_add(&m->stats->view_notifies, 1);
+    if (m->view_async) {
+        __atomic_fetch_add(&m->sync->view_generation, 1, __ATOMIC_RELEASE);
+        return;
+    }
+    sem_post(&m->sync->view_ready);
+    sem_wait(&m->sync->view_done);
+}
+
+// Marca el fin de la partida y despierta a los jugadores para que lo vean
+static void announce_finished(match_t *m) {
+    game_state_t *gs = m->game->state;
+    writer_enter(m->sync);
+    gs->game_finished = true;
+    writer_exit(m->sync);
+    if (m->stats)
+        __atomic_store_n(&m->stats->finished, 1, __ATOMIC_RELAXED);
+    for (unsigned i = 0; i < m->num_players; ++i)
+        sem_post(player_sem(m->sync, i));
+}
+
+static void finish(match_t *m) {
+    if (!m->game->state->game_finished)
+        announce_finished(m);
+
+    // Terminar todos los procesos hijos que sigan vivos con SIGKILL directamente
+    // esto lo agregue porque sino el /bin/yes no termina y el master se queda bloqueado en el wait
+    for (unsigned i = 0; i < m->num_players; ++i) {
+        if (m->pipes[i].alive && m->pipes[i].pid > 0 && !m->pool) {
+            kill(m->pipes[i].pid, SIGKILL);
+        }
+    }
+    notify_view(m);
+}
+
+int parse_read_protocol(const char *name) {
+    if (!strcmp(name, "rw"))
+        return READ_PROTOCOL_RW;
+    if (!strcmp(name, "seqlock"))
+        return READ_PROTOCOL_SEQLOCK;
+    return -1;
+}
+
+int parse_move_transport(const char *name) {
+    if (!strcmp(name, "pipe"))
+        return MOVE_TRANSPORT_PIPE;
+    if (!strcmp(name, "ring"))
+        return MOVE_TRANSPORT_RING;
+    return -1;
+}
+
+int parse_board_gen(const char *name) {
+    if (!strcmp(name, "rand"))
+        return BOARD_GEN_RAND;
+    if (!strcmp(name, "counter"))
+        return BOARD_GEN_COUNTER;
+    return -1;
+}
+
+int parse_map_opts(const char *list) {
+    static const struct { const char *name; unsigned opt; } names[] = {
+        { "huge", SHM_MAP_HUGEPAGES },
+        { "prefault", SHM_MAP_PREFAULT },
+        { "lock", SHM_MAP_LOCK },
+    };
+    unsigned opts = 0;
+    const char *p = list;
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        bool found = false;
+        for (size_t k = 0; k < sizeof(names) / sizeof(names[0]); k++) {
+            if (strlen(names[k].name) == len && !strncmp(p, names[k].name, len)) {
+                opts |= names[k].opt;
+                found = true;
+            }
+        }
+        if (!found)
+            return -1;
+        p += len;
+        if (*p == ',')
+            p++;
+    }
+    return (int)opts;
+}
+
+static long elapsed_us(const struct timespec *from, const struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1000000L + (to->tv_nsec - from->tv_nsec) / 1000L;
+}
+
+static void close_player(match_t *m, unsigned i) {
+    // El pipe de un jugador del pool es del pool: solo se lo deja de leer
+    if (!m->pool)
+        close(m->pipes[i].read_fd); // también lo saca del epoll
+    m->pipes[i].read_fd = -1;
+    m->pipes[i].alive = 0;
+}
+
+static void mark_player_gone(match_t *m, unsigned i) {
+    writer_enter(m->sync);
+    block_player(m->game, i);
+    writer_exit(m->sync);
+    close_player(m, i);
+}
+
+// Lee del pipe hasta vaciarlo (epoll está en modo edge-triggered) o del buffer circular,
+// hasta llenar el buffer del jugador
+static void fill_input(pipe_info_t *p) {
+    if (p->read_fd < 0 || p->eof)
+        return;
+    if (p->in_head > 0) {
+        memmove(p->inbuf, p->inbuf + p->in_head, p->in_count);
+        p->in_head = 0;
+    }
+    if (p->ring) {
+        // closed se lee antes: si después el buffer está vacío, no va a llegar nada más
+        bool closed = move_ring_closed(p->ring);
+        unsigned got = move_ring_pop(p->ring, p->inbuf + p->in_count, PLAYER_INBUF_SIZE - p->in_count);
+        p->in_count += got;
+        if (p->stats && got > 0) {
+            stats_add(&p->stats->bytes_read, got);
+            stats_add(&p->stats->reads, 1);
+        }
+        p->more = !move_ring_empty(p->ring);
+        if (closed && !p->more)
+            p->eof = true;
+        return;
+    }
+    p->more = false;
+    while (p->in_count < PLAYER_INBUF_SIZE) {
+        ssize_t n = read(p->read_fd, p->inbuf + p->in_count, PLAYER_INBUF_SIZE - p->in_count);
+        if (n > 0) {
+            p->in_count += (unsigned)n;
+            if (p->stats) {
+                stats_add(&p->stats->bytes_read, (uint64_t)n);
+                stats_add(&p->stats->reads, 1);
+            }
+        } else if (n == 0) {
+            p->eof = true;
+            return;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN)
+                p->eof = true;
+            else if (p->stats)
+                stats_add(&p->stats->eagain, 1);
+            return;
+        }
+    }
+    p->more = true;
+}
+
+// El jugador tiene algo para procesar: un movimiento o el fin de su pipe
+static bool has_input(const pipe_info_t *p) {
+    return p->read_fd >= 0 && (p->in_count > 0 || p->eof);
+}
+
+// Lo que manda un jugador que espera el tick queda en su buffer hasta el tick
+static bool can_move(const pipe_info_t *p) {
+    return has_input(p) && !p->tick_wait;
+}
+
+// La cola de listos tiene a todo jugador que puede mover, en el orden en que llegó lo suyo: lo
+// encolan los eventos de epoll (o el bitmap de los buffers circulares), el tick y la ronda misma
+// cuando después de take_move le queda algo en el buffer. Así cada despertada cuesta lo que los
+// listos y no lo que todos los jugadores
+static void push_ready(match_t *m, unsigned i) {
+    pipe_info_t *p = &m->pipes[i];
+    if (p->queued || !can_move(p))
+        return;
+    p->queued = true;
+    m->ready_q[(m->ready_head + m->ready_count++) % m->num_players] = i;
+}
+
+static unsigned pop_ready(match_t *m) {
+    unsigned i = m->ready_q[m->ready_head];
+    m->ready_head = (m->ready_head + 1) % m->num_players;
+    m->ready_count--;
+    m->pipes[i].queued = false;
+    return i;
+}
+
+// Saca el próximo movimiento del buffer del jugador; false si solo queda el EOF
+static bool take_move(pipe_info_t *p, unsigned char *dir) {
+    if (p->in_count == 0)
+        return false;
+    *dir = p->inbuf[p->in_head++];
+    p->in_count--;
+    if (p->in_count == 0) {
+        p->in_head = 0;
+        if (p->more)
+            fill_input(p);
+    }
+    return true;
+}
+
+static long long ts_ns(const struct timespec *ts) {
+    return (long long)ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+// Llegó la respuesta al turno dado (lo que haya además de los movimientos tardíos): se mide el turno
+static void note_arrival(match_t *m, unsigned i, const struct timespec *now) {
+    pipe_info_t *p = &m->pipes[i];
+    if (p->read_fd < 0 || !p->awaiting || p->in_count <= p->discard)
+        return;
+    m->rtt_sum_ns += (unsigned long long)(ts_ns(now) - ts_ns(&p->posted));
+    m->rtt_count++;
+    p->awaiting = false;
+    LAT_RECORD(m->lat, i, LAT_TURN, p->posted, *now);
+}
+
+static void deadline_push(match_t *m, turn_deadline_t d) {
+    if (m->num_deadlines == m->cap_deadlines) {
+        unsigned cap = m->cap_deadlines ? 2 * m->cap_deadlines : 64;
+        turn_deadline_t *grown = realloc(m->deadlines, cap * sizeof(*grown));
+        if (!grown)
+            return; // sin memoria ese turno queda sin plazo
+        m->deadlines = grown;
+        m->cap_deadlines = cap;
+    }
+    unsigned k = m->num_deadlines++;
+    while (k > 0 && m->deadlines[(k - 1) / 2].deadline_ns > d.deadline_ns) {
+        m->deadlines[k] = m->deadlines[(k - 1) / 2];
+        k = (k - 1) / 2;
+    }
+    m->deadlines[k] = d;
+}
+
+static turn_deadline_t deadline_pop(match_t *m) {
+    turn_deadline_t top = m->deadlines[0], last = m->deadlines[--m->num_deadlines];
+    unsigned n = m->num_deadlines, k = 0;
+    while (2 * k + 1 < n) {
+        unsigned c = 2 * k + 1;
+        if (c + 1 < n && m->deadlines[c + 1].deadline_ns < m->deadlines[c].deadline_ns)
+            c++;
+        if (m->deadlines[c].deadline_ns >= last.deadline_ns)
+            break;
+        m->deadlines[k] = m->deadlines[c];
+        k = c;
+    }
+    if (n > 0)
+        m->deadlines[k] = last;
+    return top;
+}
+
+static void give_turn(match_t *m, unsigned i) {
+    // Un jugador bloqueado recibe un último post para que lo vea y se vaya; después ya no se lo
+    // despierta, aunque siga mandando movimientos
+    bool blocked = game_player(m->game->state, m->game->extra_players, i)->is_blocked;
+    if (blocked) {
+        if (m->pipes[i].blocked_woken)
+            return;
+        m->pipes[i].blocked_woken = true;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &m->pipes[i].posted);
+    m->pipes[i].awaiting = true;
+    m->pipes[i].turn_seq++;
+    if (m->turn_ms > 0 && !blocked)
+        deadline_push(m, (turn_deadline_t){ ts_ns(&m->pipes[i].posted) + m->turn_ms * 1000000LL, i, m->pipes[i].turn_seq });
+    sem_post(player_sem(m->sync, i));
+    LAT_DECL(posted);
+    LAT_STAMP(posted);
+    LAT_RECORD(m->lat, i, LAT_POST, m->pipes[i].posted, posted);
+}
+
+// Después de un movimiento (o de perder el turno): sin ticks el turno siguiente se da ya; con
+// ticks se da en el próximo, sin dormir en el medio del loop
+static void next_turn(match_t *m, unsigned i) {
+    if (m->delay_ms <= 0) {
+        give_turn(m, i);
+        return;
+    }
+    if (!m->pipes[i].tick_wait) {
+        m->pipes[i].tick_wait = true;
+        m->tick_list[m->tick_waiting++] = i;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &m->pipes[i].moved_at);
+}
+
+// Un plazo sigue en pie mientras el jugador no conteste ese turno y siga jugando
+static bool deadline_live(const match_t *m, const turn_deadline_t *d) {
+    const pipe_info_t *p = &m->pipes[d->idx];
+    return p->awaiting && p->turn_seq == d->seq && p->read_fd >= 0 &&
+           !game_player(m->game->state, m->game->extra_players, d->idx)->is_blocked;
+}
+
+// Turnos vencidos y tick. Un jugador que no contestó a tiempo pierde el turno: el movimiento
+// que mande por ese turno se descarta al llegar y recibe el siguiente como si hubiera movido
+static void run_schedule(match_t *m, const struct timespec *now) {
+    long long t = ts_ns(now);
+    while (m->num_deadlines > 0 && m->deadlines[0].deadline_ns <= t) {
+        turn_deadline_t d = deadline_pop(m);
+        if (!deadline_live(m, &d))
+            continue;
+        pipe_info_t *p = &m->pipes[d.idx];
+        p->awaiting = false;
+        p->discard++;
+        m->forfeits++;
+        next_turn(m, d.idx);
+    }
+
+    if (m->delay_ms <= 0 || t < ts_ns(&m->next_tick))
+        return;
+    for (unsigned k = 0; k < m->tick_waiting; k++) {
+        unsigned i = m->tick_list[k];
+        pipe_info_t *p = &m->pipes[i];
+        p->tick_wait = false;
+        LAT_RECORD(m->lat, i, LAT_DELAY, p->moved_at, *now);
+        if (p->read_fd < 0)
+            continue;
+        give_turn(m, i);
+        // Lo que mandó mientras esperaba ya está en su buffer
+        note_arrival(m, i, now);
+        push_ready(m, i);
+    }
+    m->tick_waiting = 0;
+    // Ritmo fijo: si el loop se atrasó más de un tick no se recuperan los perdidos
+    long long period = m->delay_ms * 1000000LL, next = ts_ns(&m->next_tick) + period;
+    if (next <= t)
+        next = t + period;
+    m->next_tick.tv_sec = (time_t)(next / 1000000000LL);
+    m->next_tick.tv_nsec = (long)(next % 1000000000LL);
+}
+
+// Cuánto se puede esperar movimientos antes del próximo plazo o tick, en ms redondeados para arriba.
+// Los plazos de turnos ya contestados se sacan antes: si no, cada uno despertaría al master
+static long schedule_wait_ms(match_t *m, const struct timespec *now, long remain_ms) {
+    long long t = ts_ns(now), until = -1;
+    while (m->num_deadlines > 0 && !deadline_live(m, &m->deadlines[0]))
+        deadline_pop(m);
+    if (m->num_deadlines > 0)
+        until = m->deadlines[0].deadline_ns;
+    if (m->tick_waiting > 0 && (until < 0 || ts_ns(&m->next_tick) < until))
+        until = ts_ns(&m->next_tick);
+    if (until < 0)
+        return remain_ms;
+    long ms = until <= t ? 0 : (long)((until - t + 999999) / 1000000);
+    return ms < remain_ms ? ms : remain_ms;
+}
+
+// writer_enter para aplicar movimientos; si hay región de estadísticas se mide la espera
+static void lock_for_moves(match_t *m) {
+    if (!m->stats) {
+        writer_enter(m->sync);
+        return;
+    }
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    writer_enter(m->sync);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    stats_add(&m->stats->lock_wait_ns, (uint64_t)((t1.tv_sec - t0.tv_sec) * 1000000000LL + (t1.tv_nsec - t0.tv_nsec)));
+    stats_add(&m->stats->lock_acquisitions, 1);
+}
+
+// Una ronda en la que todos cerraron su pipe toma el lock pero no aplica nada: no cuenta
+static void count_moves(match_t *m, unsigned applied, unsigned valid) {
+    if (applied == 0)
+        return;
+    m->moves_applied += applied;
+    m->move_locks++;
+    if (m->stats) {
+        stats_add(&m->stats->moves_applied, applied);
+        stats_add(&m->stats->moves_valid, valid);
+    }
+}
+
+static void process_move(match_t *m, unsigned i, struct timespec *last_valid) {
+    unsigned char dir;
+    if (!take_move(&m->pipes[i], &dir)) {
+        mark_player_gone(m, i);
+        if (m->rec)
+            recorder_gone(m->rec, i);
+        m->reach_changed = true;
+        return;
+    }
+    if (m->pipes[i].discard > 0) {
+        m->pipes[i].discard--; // llegó tarde: su turno ya se le dio de nuevo
+        return;
+    }
+
+    game_state_t *gs = m->game->state;
+    player_t *pl = game_player(gs, m->game->extra_players, i);
+    int was_valid;
+    unsigned int invalid_before, invalid_after;
+    LAT_DECL(t_lock, t_locked, t_applied, t_begin, t_end);
+    LAT_STAMP(t_lock);
+    lock_for_moves(m);
+    LAT_STAMP(t_locked);
+    invalid_before = pl->invalid_moves;
+    unsigned score_before = pl->score;
+    was_valid = apply_move(m->game, (int)i, dir);
+    invalid_after = pl->invalid_moves;
+    LAT_STAMP(t_applied);
+    writer_exit(m->sync);
+    LAT_RECORD(m->lat, i, LAT_LOCK, t_lock, t_locked);
+    LAT_RECORD(m->lat, i, LAT_APPLY, t_locked, t_applied);
+    if (m->rec)
+        recorder_move(m->rec, i, dir);
+    count_moves(m, 1, was_valid ? 1 : 0);
+
+    if (was_valid) {
+        clock_gettime(CLOCK_MONOTONIC, last_valid);
+        if (m->reach) {
+            reach_capture(m->reach, m->game, idx(pl->x, pl->y, gs->board_width), pl->score - score_before);
+            m->reach_changed = true;
+        }
+    }
+
+    // Actualizar la vista también cuando aumentan los movimientos inválidos
+    if (was_valid || invalid_after != invalid_before) {
+        LAT_STAMP(t_begin);
+        notify_view(m);
+        LAT_STAMP(t_end);
+        if (m->view_bin)
+            LAT_RECORD(m->lat, i, LAT_VIEW, t_begin, t_end);
+    }
+
+    next_turn(m, i);
+}
+
+typedef enum {
+    ROUND_MOVED = 0,
+    ROUND_GONE,      // cerró su pipe
+    ROUND_LATE,      // el movimiento era de un turno perdido por plazo
+} round_outcome_t;
+
+// Modo batch: toda la ronda (movimientos y jugadores que cerraron su pipe) en una sola
+// sección crítica, después un único cuadro de la vista. Cada jugador sigue recibiendo un
+// post de player_ready por cada movimiento aplicado.
+static void process_round(match_t *m, const unsigned *round, unsigned cnt, unsigned char *outcome, struct timespec *last_valid) {
+    unsigned applied = 0, valid = 0;
+
+    LAT_DECL(t_lock, t_locked, t_apply, t_applied, t_begin, t_view);
+    LAT_STAMP(t_lock);
+    lock_for_moves(m);
+    LAT_STAMP(t_locked);
+    for (unsigned k = 0; k < cnt; k++) {
+        unsigned i = round[k];
+        unsigned char dir;
+        outcome[k] = ROUND_MOVED;
+        if (!take_move(&m->pipes[i], &dir)) {
+            outcome[k] = ROUND_GONE;
+            block_player(m->game, i);
+            if (m->rec)
+                recorder_gone(m->rec, i);
+            m->reach_changed = true;
+            continue;
+        }
+        if (m->pipes[i].discard > 0) {
+            outcome[k] = ROUND_LATE;
+            m->pipes[i].discard--;
+            continue;
+        }
+        // Todo movimiento cambia el estado (posición o contador de inválidos)
+        const player_t *pl = game_player(m->game->state, m->game->extra_players, i);
+        unsigned score_before = pl->score;
+        LAT_STAMP(t_apply);
+        int was_valid = apply_move(m->game, (int)i, dir);
+        LAT_STAMP(t_applied);
+        if (was_valid) {
+            valid++;
+            if (m->reach) {
+                reach_capture(m->reach, m->game, idx(pl->x, pl->y, m->game->state->board_width), pl->score - score_before);
+                m->reach_changed = true;
+            }
+        }
+        LAT_RECORD(m->lat, i, LAT_APPLY, t_apply, t_applied);
+        if (m->rec)
+            recorder_move(m->rec, i, dir);
+        applied++;
+    }
+    writer_exit(m->sync);
+    count_moves(m, applied, valid);
+    if (valid > 0)
+        clock_gettime(CLOCK_MONOTONIC, last_valid);
+    LAT_STAMP(t_begin);
+    notify_view(m);
+    LAT_STAMP(t_view);
+
+    // El lock y la vista son de toda la ronda: cuentan para cada movimiento aplicado
+    for (unsigned k = 0; k < cnt; k++) {
+        if (outcome[k] == ROUND_GONE) {
+            close_player(m, round[k]);
+            continue;
+        }
+        if (outcome[k] == ROUND_LATE)
+            continue;
+        LAT_RECORD(m->lat, round[k], LAT_LOCK, t_lock, t_locked);
+        if (m->view_bin)
+            LAT_RECORD(m->lat, round[k], LAT_VIEW, t_begin, t_view);
+        next_turn(m, round[k]);
+    }
+}
+
+// Un jugador que muere sin cerrar su buffer circular se trata como un EOF del pipe
+static void check_dead_players(match_t *m) {
+    for (unsigned i = 0; i < m->num_players; i++) {
+        pipe_info_t *p = &m->pipes[i];
+        if (p->read_fd < 0 || p->eof || p->pid <= 0)
+            continue;
+        siginfo_t si;
+        si.si_pid = 0;
+        if (waitid(P_PID, (id_t)p->pid, &si, WEXITED | WNOHANG | WNOWAIT) == 0 && si.si_pid == p->pid) {
+            fill_input(p);
+            if (!p->more)
+                p->eof = true;
+            push_ready(m, i);
+        }
+    }
+}
+
+// Lee los buffers circulares marcados en el bitmap (y los limpia) y encola a sus jugadores;
+// devuelve cuántos leyó. Cuesta una palabra cada 64 jugadores más los buffers marcados
+static unsigned collect_rings(match_t *m) {
+    unsigned got = 0, words = (m->num_players + 63) / 64;
+    for (unsigned w = 0; w < words; w++) {
+        for (uint64_t bits = move_rings_take_nonempty(m->rings, w); bits; bits &= bits - 1) {
+            unsigned i = w * 64 + (unsigned)__builtin_ctzll(bits);
+            fill_input(&m->pipes[i]);
+            push_ready(m, i);
+            got++;
+        }
+    }
+    return got;
+}
+
+// Lee los buffers marcados; si no hay ninguno y la cola está vacía duerme en el futex del timbre.
+// Devuelve la cantidad de buffers leídos
+static unsigned wait_rings(match_t *m, long remain_ms) {
+    unsigned got = collect_rings(m);
+    if (got > 0 || m->ready_count > 0 || remain_ms <= 0)
+        return got;
+
+    // Se anuncia la espera antes de leer el timbre: un jugador que escribe después de
+    // la última revisión ve master_waiting y despierta al master (o cambia el timbre)
+    move_rings_t *r = m->rings;
+    __atomic_store_n(&r->master_waiting, 1, __ATOMIC_SEQ_CST);
+    uint32_t bell = __atomic_load_n(&r->doorbell, __ATOMIC_SEQ_CST);
+    got = collect_rings(m);
+    if (got == 0) {
+        long ms = remain_ms < RING_IDLE_CHECK_MS ? remain_ms : RING_IDLE_CHECK_MS;
+        struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L };
+        if (futex_wait(&r->doorbell, bell, &ts) == -1 && errno == ETIMEDOUT)
+            check_dead_players(m);
+        if (m->stats)
+            stats_add(&m->stats->wakeups, 1);
+    }
+    __atomic_store_n(&r->master_waiting, 0, __ATOMIC_RELAXED);
+    if (got > 0)
+        return got;
+    return collect_rings(m);
+}
+
+// Espera con epoll a que algún pipe tenga datos; -1 si epoll falló
+static int wait_pipes(match_t *m, int epfd, bool poll_only, long remain_ms) {
+    struct epoll_event events[EPOLL_EVENTS];
+    int nev = epoll_wait(epfd, events, EPOLL_EVENTS, poll_only ? 0 : (int)remain_ms);
+    if (m->stats && !poll_only)
+        stats_add(&m->stats->wakeups, 1);
+    if (nev < 0) {
+        if (errno == EINTR)
+            return 0;
+        perror("Error: epoll_wait() failed while waiting for player input");
+        return -1;
+    }
+    for (int e = 0; e < nev; e++) {
+        fill_input(&m->pipes[events[e].data.u32]);
+        push_ready(m, events[e].data.u32);
+    }
+    return nev;
+}
+
+// Loop principal: epoll (o el timbre de los buffers circulares) avisa quién mandó algo y en
+// cada ronda se procesa a lo sumo un movimiento por jugador, empezando por uno distinto cada vez
+static void play(match_t *m) {
+    unsigned n = m->num_players;
+    int epfd = -1;
+    if (!m->rings) {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (epfd == -1) {
+            perror("Error: epoll_create1() failed");
+            finish(m);
+            return;
+        }
+    }
+    unsigned active = 0;
+    for (unsigned i = 0; i < n; i++) {
+        if (m->pipes[i].read_fd < 0)
+            continue;
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLET, .data.u32 = i };
+        if (epfd != -1 && epoll_ctl(epfd, EPOLL_CTL_ADD, m->pipes[i].read_fd, &ev) == -1) {
+            perror("Error: epoll_ctl() failed");
+            close(epfd);
+            finish(m);
+            return;
+        }
+        active++;
+    }
+
+    // La ronda se arma en ready[0, cnt) y empieza en ready + first: las first entradas de antes
+    // se copian al final, así se rota sin ordenar
+    unsigned *ready = malloc(2 * n * sizeof(*ready));
+    unsigned char *outcome = malloc(n);
+    m->ready_q = malloc(n * sizeof(*m->ready_q));
+    m->tick_list = malloc(n * sizeof(*m->tick_list));
+    if (!ready || !outcome || !m->ready_q || !m->tick_list) {
+        free(ready);
+        free(outcome);
+        free(m->ready_q);
+        free(m->tick_list);
+        m->ready_q = NULL;
+        m->tick_list = NULL;
+        perror("Error: could not allocate ready list");
+        if (epfd != -1)
+            close(epfd);
+        finish(m);
+        return;
+    }
+
+    struct timespec last_valid;
+    clock_gettime(CLOCK_MONOTONIC, &last_valid);
+    unsigned next_idx = 0;
+    bool ending = false;  // todos bloqueados: ya se avisó el fin y se espera que los jugadores se vayan
+    struct timespec ending_at;
+    if (m->delay_ms > 0) {
+        m->next_tick = last_valid;
+        m->next_tick.tv_sec += m->delay_ms / 1000;
+        m->next_tick.tv_nsec += (m->delay_ms % 1000) * 1000000L;
+        if (m->next_tick.tv_nsec >= 1000000000L) {
+            m->next_tick.tv_sec++;
+            m->next_tick.tv_nsec -= 1000000000L;
+        }
+    }
+
+    while (active > 0) {
+        struct timespec now;
+        // El contador lo mantiene apply_move, así que nadie recorre el tablero para saberlo
+        if (!ending && m->game->num_blocked == n) {
+            if (m->pool)
+                break; // los jugadores del pool no se van: les alcanza con ver el fin
+            announce_finished(m);
+            ending = true;
+            clock_gettime(CLOCK_MONOTONIC, &ending_at);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long remain_ms = ending ? BLOCKED_GRACE_MS - elapsed_us(&ending_at, &now) / 1000L
+                                : m->timeout_s * 1000L - elapsed_us(&last_valid, &now) / 1000L;
+        if (remain_ms <= 0)
+            break;
+        long wait_ms = schedule_wait_ms(m, &now, remain_ms);
+
+        int got;
+        if (m->rings)
+            got = (int)wait_rings(m, wait_ms);
+        else
+            got = wait_pipes(m, epfd, m->ready_count > 0 || wait_ms == 0, wait_ms);
+        if (got < 0)
+            break;
+
+        // Primero se anotan los movimientos que llegaron (a tiempo), después vencen los plazos
+        // y se dan los turnos del tick
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for (unsigned k = 0; k < m->ready_count; k++)
+            note_arrival(m, m->ready_q[(m->ready_head + k) % n], &now);
+        run_schedule(m, &now);
+
+        // La ronda son los que están en la cola, a partir del primero desde next_idx; los que
+        // quedan con algo en el buffer vuelven a la cola para la ronda siguiente
+        unsigned cnt = 0, first = 0, first_key = n;
+        for (unsigned queued = m->ready_count; queued > 0; queued--) {
+            unsigned i = pop_ready(m);
+            if (!can_move(&m->pipes[i]))
+                continue; // quedó esperando el tick
+            unsigned key = (i + n - next_idx) % n;
+            if (key < first_key) {
+                first_key = key;
+                first = cnt;
+            }
+            ready[cnt++] = i;
+        }
+        if (cnt == 0)
+            continue; // se vuelve a chequear el timeout
+        memcpy(ready + cnt, ready, first * sizeof(*ready));
+        const unsigned *round = ready + first;
+
+        if (m->batch_moves) {
+            process_round(m, round, cnt, outcome, &last_valid);
+        } else {
+            for (unsigned k = 0; k < cnt; k++)
+                process_move(m, round[k], &last_valid);
+        }
+        for (unsigned k = 0; k < cnt; k++) {
+            unsigned i = round[k];
+            if (m->pipes[i].read_fd < 0)
+                active--;
+            else
+                push_ready(m, i);
+        }
+        next_idx = (next_idx + 1) % n;
+
+        // Las rondas sin capturas (solo inválidos o tardíos) no cambian ninguna componente
+        if (!ending && m->reach && m->reach_changed) {
+            m->reach_changed = false;
+            if (reach_decided(m->reach, m->game)) {
+                m->decided = true;
+                break;
+            }
+        }
+    }
+
+    free(ready);
+    free(outcome);
+    free(m->ready_q);
+    free(m->tick_list);
+    m->ready_q = NULL;
+    m->tick_list = NULL;
+    if (epfd != -1)
+        close(epfd);
+    finish(m);
+}
+
+static int exit_code(int status) {
+    if (WIFEXITED(status))
+        return WEXITSTATUS(status);
+    if (WIFSIGNALED(status))
+        return WTERMSIG(status);
+    return -1;
+}
+
+player_pool_t *player_pool_create(char **player_bins, unsigned num_players) {
+    player_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool)
+        return NULL;
+    size_t n = 0;
+    while (environ[n])
+        n++;
+    pool->num_players = num_players;
+    pool->bins = player_bins;
+    pool->slots = malloc(num_players * sizeof(pool_slot_t));
+    pool->envp = malloc((n + 2) * sizeof(char *));
+    if (!pool->slots || !pool->envp) {
+        free(pool->slots);
+        free(pool->envp);
+        free(pool);
+        return NULL;
+    }
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!has_key(environ[i], ENV_PLAYER_POOL))
+            pool->envp[k++] = environ[i];
+    }
+    pool->envp[k++] = ENV_PLAYER_POOL "=1";
+    pool->envp[k] = NULL;
+    for (unsigned i = 0; i < num_players; i++)
+        pool->slots[i] = (pool_slot_t){ .pid = -1, .ctl_fd = -1, .move_fd = -1 };
+    // Un jugador que murió entre partidas se detecta en el write de la línea, no con la señal
+    signal(SIGPIPE, SIG_IGN);
+    return pool;
+}
+
+static int pool_spawn(player_pool_t *pool, unsigned i) {
+    pool_slot_t *s = &pool->slots[i];
+    int ctl[2], mv[2];
+    if (pipe2(ctl, O_CLOEXEC) == -1)
+        return -1;
+    if (pipe2(mv, O_CLOEXEC) == -1) {
+        close(ctl[0]);
+        close(ctl[1]);
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(ctl[0]);
+        close(ctl[1]);
+        close(mv[0]);
+        close(mv[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        dup2(ctl[0], STDIN_FILENO);
+        dup2(mv[1], STDOUT_FILENO);
+        execle(pool->bins[i], pool->bins[i], (char *)NULL, pool->envp);
+        perror("Error: failed to exec pooled player");
+        _exit(EXEC_ERROR_CODE);
+    }
+    close(ctl[0]);
+    close(mv[1]);
+    fcntl(mv[0], F_SETFL, O_NONBLOCK);
+    *s = (pool_slot_t){ .pid = pid, .ctl_fd = ctl[1], .move_fd = mv[0] };
+    return 0;
+}
+
+// Saca al jugador del pool (se relanza en la próxima partida); devuelve su código de salida
+static int pool_retire(player_pool_t *pool, unsigned i) {
+    pool_slot_t *s = &pool->slots[i];
+    int code = -1, status;
+    if (s->pid > 0) {
+        kill(s->pid, SIGKILL);
+        if (waitpid(s->pid, &status, 0) > 0)
+            code = exit_code(status);
+    }
+    if (s->ctl_fd >= 0)
+        close(s->ctl_fd);
+    if (s->move_fd >= 0)
+        close(s->move_fd);
+    *s = (pool_slot_t){ .pid = -1, .ctl_fd = -1, .move_fd = -1 };
+    return code;
+}
+
+void player_pool_destroy(player_pool_t *pool) {
+    if (!pool)
+        return;
+    for (unsigned i = 0; i < pool->num_players; i++) {
+        pool_slot_t *s = &pool->slots[i];
+        if (s->pid <= 0)
+            continue;
+        close(s->ctl_fd); // EOF en el stdin: el jugador termina solo
+        close(s->move_fd);
+        waitpid(s->pid, NULL, 0);
+    }
+    free(pool->slots);
+    free(pool->envp);
+    free(pool);
+}
+
+// Espera el POOL_GAME_DONE del jugador i: lo que llegue antes son movimientos que la partida ya
+// no aplicó. Devuelve 0 si el jugador queda listo para la próxima partida, o el código con que
+// salió si se lo tuvo que sacar del pool
+static int pool_release(player_pool_t *pool, unsigned i, const pipe_info_t *p, const struct timespec *deadline) {
+    if (p->eof)
+        return pool_retire(pool, i); // pipe cerrado o buffer circular sin dueño: murió
+    if (memchr(p->inbuf + p->in_head, POOL_GAME_DONE, p->in_count))
+        return SUCCESS;
+    int fd = pool->slots[i].move_fd;
+    unsigned char buf[PLAYER_INBUF_SIZE];
+    while (1) {
+        ssize_t n = read(fd, buf, sizeof buf);
+        if (n > 0) {
+            if (memchr(buf, POOL_GAME_DONE, (size_t)n))
+                return SUCCESS;
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EINTR))
+            break;
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long ms = elapsed_us(&now, deadline) / 1000L;
+        if (ms <= 0)
+            break;
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        poll(&pfd, 1, (int)ms);
+    }
+    return pool_retire(pool, i);
+}
+
+// La misma línea para todos: el jugador se encuentra por su pid en el estado
+static int spawn_pooled(const game_args_t *args, match_t *m, const char *state_name, const char *sync_name,
+                        const char *moves_name, const char *stats_name) {
+    player_pool_t *pool = args->pool;
+    char line[POOL_LINE_MAX];
+    int len = snprintf(line, sizeof line, "%d %d %s %s %s %s\n", args->board_width, args->board_height,
+                       state_name, sync_name, moves_name, stats_name);
+    if (len < 0 || (size_t)len >= sizeof line || pool->num_players != (unsigned)args->num_players) {
+        fprintf(stderr, "Error: the player pool does not match this game\n");
+        return ERROR_INVALID_ARGS;
+    }
+    game_state_t *gs = m->game->state;
+    for (unsigned i = 0; i < pool->num_players; i++) {
+        pool_slot_t *s = &pool->slots[i];
+        player_t *pl = game_player(gs, m->game->extra_players, i);
+        // Uno que murió entre partidas recién se nota en el write: se lo relanza una vez
+        bool sent = false;
+        for (int attempt = 0; attempt < 2 && !sent; attempt++) {
+            if (s->pid <= 0 && pool_spawn(pool, i) == -1) {
+                perror("Error: could not launch pooled player");
+                return ERROR_FORK;
+            }
+            writer_enter(m->sync);
+            pl->pid = s->pid;
+            const char *slash = strrchr(pool->bins[i], '/');
+            snprintf(pl->name, MAX_NAME_LEN, "%s", slash ? slash + 1 : pool->bins[i]);
+            writer_exit(m->sync);
+            sent = write(s->ctl_fd, line, (size_t)len) == len;
+            if (!sent)
+                pool_retire(pool, i);
+        }
+        if (!sent) {
+            fprintf(stderr, "Error: pooled player %s does not take games\n", pool->bins[i]);
+            return ERROR_PIPE;
+        }
+        m->pipes[i].read_fd = s->move_fd;
+        m->pipes[i].pid = s->pid;
+        m->pipes[i].alive = 1;
+    }
+    return SUCCESS;
+}
+
+static int collect_results(match_t *m, pid_t view_pid, game_result_t *result) {
+    game_state_t *gs = m->game->state;
+    int status;
+
+    result->view_status = -1;
+    if (view_pid > 0 && waitpid(view_pid, &status, 0) > 0)
+        result->view_status = status;
+
+    result->num_players = m->num_players;
+    result->players = calloc(m->num_players, sizeof(player_t));
+    result->exit_codes = calloc(m->num_players, sizeof(int));
+    struct timespec release_by;
+    clock_gettime(CLOCK_MONOTONIC, &release_by);
+    release_by.tv_sec += POOL_RELEASE_MS / 1000;
+    release_by.tv_nsec += (POOL_RELEASE_MS % 1000) * 1000000L;
+    for (unsigned i = 0; i < m->num_players; i++) {
+        int code = -1;
+        if (m->pool) {
+            if (m->pipes[i].pid > 0)
+                code = pool_release(m->pool, i, &m->pipes[i], &release_by);
+            m->pipes[i].read_fd = -1;
+        } else if (m->pipes[i].pid > 0 && waitpid(m->pipes[i].pid, &status, 0) > 0) {
+            code = exit_code(status);
+        }
+        if (result->exit_codes)
+            result->exit_codes[i] = code;
+
+        if (result->players) {
+            reader_enter(m->sync);
+            result->players[i] = *game_player(gs, m->game->extra_players, i);
+            reader_exit(m->sync);
+        }
+
+        if (m->pipes[i].read_fd >= 0) {
+            close(m->pipes[i].read_fd);
+            m->pipes[i].read_fd = -1;
+        }
+    }
+    if (!result->players || !result->exit_codes) {
+        game_result_free(result);
+        return -1;
+    }
+    return 0;
+}
+
+void game_result_free(game_result_t *result) {
+    free(result->players);
+    free(result->exit_codes);
+    free(result->latency);
+    result->players = NULL;
+    result->exit_codes = NULL;
+    result->latency = NULL;
+    result->moves_applied = 0;
+    result->move_locks = 0;
+    result->turns_timed = 0;
+    result->turn_rtt_avg_ns = 0;
+    result->turns_forfeited = 0;
+}
+
+static int spawn_players(const game_args_t *args, match_t *m, char **envp) {
+    game_state_t *gs = m->game->state;
+    for (int i = 0; i < args->num_players; i++) {
+        pipe_info_t *p = &m->pipes[i];
+        player_t *pl = game_player(gs, m->game->extra_players, (unsigned)i);
+        int fds[2];
+        // O_CLOEXEC: los hijos siguientes no heredan los extremos de los pipes anteriores
+        if (pipe2(fds, O_CLOEXEC) == -1) {
+            perror("Error: could not create pipe for player process");
+            return ERROR_PIPE;
+        }
+        p->read_fd = fds[0];
+        p->write_fd = fds[1];
+        p->alive = 1;
+        fcntl(p->read_fd, F_SETFL, O_NONBLOCK);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("Error: could not fork player process");
+            close(fds[0]);
+            close(fds[1]);
+            p->read_fd = -1;
+            p->alive = 0;
+            return ERROR_FORK;
+        }
+        if (pid == 0) {
+            // El hijo todavía tiene el mapeo del master: publica su pid antes del exec
+            // para que el jugador se encuentre aunque arranque antes que el padre
+            pl->pid = getpid();
+            dup2(p->write_fd, 1); // el duplicado no hereda O_CLOEXEC
+            exec_with_board_args(args->player_bins[i], args->board_width, args->board_height, envp, "Error: failed to exec player");
+        }
+        close(p->write_fd);
+        p->pid = pid;
+        writer_enter(m->sync);
+        pl->pid = pid;
+        const char *bn = args->player_bins[i];
+        const char *slash = strrchr(bn, '/');
+        const char *pname = slash ? slash + 1 : bn;
+        snprintf(pl->name, MAX_NAME_LEN, "%s", pname);
+        writer_exit(m->sync);
+    }
+    return SUCCESS;
+}
+
+void ensure_fd_limit(unsigned num_players) {
+    struct rlimit rl;
+    rlim_t need = (rlim_t)num_players + 64;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < need) {
+        rl.rlim_cur = rl.rlim_max < need ? rl.rlim_max : need;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+int run_game(const game_args_t *args, game_result_t *result) {
+    if (args->plugins)
+        return run_plugin_game(args, result);
+    const char *state_name = args->shm_state ? args->shm_state : SHM_STATE;
+    const char *sync_name = args->shm_sync ? args->shm_sync : SHM_SYNC;
+    const char *moves_name = args->shm_moves ? args->shm_moves : SHM_MOVES;
+    const char *stats_name = args->shm_stats ? args->shm_stats : SHM_STATS;
+    int board_width = args->board_width, board_height = args->board_height;
+    unsigned num_players = (unsigned)args->num_players;
+    result->players = NULL;
+    result->exit_codes = NULL;
+    result->latency = NULL;
+
+    child_env_t env;
+    if (child_env_init(&env, state_name, sync_name, moves_name, stats_name) == -1) {
+        perror("Error: could not build player environment");
+        return ERROR_SHM;
+    }
+
+    // El log de cambios y la tabla de jugadores extra van a continuación del tablero, en la misma región
+    size_t state_size = game_state_region_size(board_width, board_height, args->board_format, num_players);
+    ensure_fd_limit(num_players);
+
+    struct timespec map_start, map_end;
+    struct rusage usage_start, usage_map, usage_end;
+    getrusage(RUSAGE_SELF, &usage_start);
+    clock_gettime(CLOCK_MONOTONIC, &map_start);
+
+    shm_adt game_state_shm, game_sync_shm;
+    if (shm_region_open(&game_state_shm, state_name, state_size) == -1) {
+        perror("Error: failed to open or create shared memory region for game state");
+        child_env_free(&env);
+        return ERROR_SHM;
+    }
+    if (shm_region_open(&game_sync_shm, sync_name, game_sync_size(num_players)) == -1) {
+        perror("Error: failed to open or create shared memory region for game sync");
+        game_state_unmap_destroy(game_state_shm);
+        child_env_free(&env);
+        return ERROR_SHM;
+    }
+
+    game_state_t *gs = NULL;
+    game_sync_t *sync = NULL;
+    if (game_state_map(game_state_shm, (unsigned short)board_width, (unsigned short)board_height, args->board_format, args->state_map_opts, &gs) == -1 ||
+        game_sync_map(game_sync_shm, &sync) == -1) {
+        perror("Error: failed to map game shared memory");
+        game_state_unmap_destroy(game_state_shm);
+        game_sync_unmap_destroy(game_sync_shm);
+        child_env_free(&env);
+        return ERROR_SHM;
+    }
+
+    shm_adt moves_shm = NULL;
+    move_rings_t *rings = NULL;
+    if (args->move_transport == MOVE_TRANSPORT_RING &&
+        (shm_region_open(&moves_shm, moves_name, move_rings_size(num_players)) == -1 ||
+         move_rings_map(moves_shm, num_players, &rings) == -1)) {
+        perror("Error: failed to open or map shared memory region for player moves");
+        if (moves_shm)
+            move_rings_unmap_destroy(moves_shm);
+        game_state_unmap_destroy(game_state_shm);
+        game_sync_unmap_destroy(game_sync_shm);
+        child_env_free(&env);
+        return ERROR_SHM;
+    }
+
+    // Sin la región de estadísticas la partida se juega igual
+    shm_adt stats_shm = NULL;
+    game_stats_t *stats = NULL;
+    if (shm_region_open(&stats_shm, stats_name, game_stats_size(num_players)) == -1 ||
+        game_stats_map(stats_shm, num_players, &stats) == -1) {
+        perror("Warning: could not create the stats region");
+        if (stats_shm)
+            game_stats_unmap_destroy(stats_shm);
+        stats_shm = NULL;
+        stats = NULL;
+    }
+
+    game_t game = { .state = gs, .format = args->board_format };
+    game.deltas = (delta_log_t *)((char *)gs + delta_log_offset(board_width, board_height, args->board_format));
+    game.deltas->head = 0;
+    game.deltas->capacity = DELTA_LOG_CAPACITY;
+    if (num_players > MAX_PLAYERS)
+        game.extra_players = (player_t *)((char *)gs + extra_players_offset(board_width, board_height, args->board_format));
+
+    sync->read_protocol = args->read_protocol;
+    sync->features = GAME_FEATURE_DELTA_LOG;
+    sync->state_map_opts = args->state_map_opts;
+    sync->board_format = args->board_format;
+    sync->move_transport = rings ? MOVE_TRANSPORT_RING : MOVE_TRANSPORT_PIPE;
+    sync->view_fps = args->view_fps > 0 ? (unsigned)args->view_fps : 0;
+    clock_gettime(CLOCK_MONOTONIC, &map_end);
+    getrusage(RUSAGE_SELF, &usage_map);
+
+    writer_enter(sync);
+    gs->board_width = (unsigned short) board_width;
+    gs->board_height = (unsigned short) board_height;
+    gs->num_players = num_players;
+    gs->game_finished = false;
+    init_board(&game, args->seed, args->board_gen);
+    place_players(&game);
+    if (game_track_neighbors(&game) == -1)
+        perror("Warning: could not track free neighbors, blocked players are detected only when they leave");
+    writer_exit(sync);
+    reach_t reach;
+    bool reach_ok = args->early_finish && reach_init(&reach, &game) == 0;
+    if (args->early_finish && !reach_ok)
+        perror("Warning: could not track free components, the game will not finish early");
+
+    struct timespec init_end;
+    clock_gettime(CLOCK_MONOTONIC, &init_end);
+
+    getrusage(RUSAGE_SELF, &usage_end);
+    result->map_faults = usage_map.ru_minflt - usage_start.ru_minflt;
+    result->init_faults = usage_end.ru_minflt - usage_map.ru_minflt;
+    result->state_bytes = state_size;
+    result->map_us = elapsed_us(&map_start, &map_end);
+    result->init_us = elapsed_us(&map_end, &init_end);
+
+    int rc = SUCCESS;
+    pid_t view_pid = -1;
+    if (args->view_bin) {
+        view_pid = fork();
+        if (view_pid < 0) {
+            perror("Error: could not fork view process");
+            rc = ERROR_FORK;
+        } else if (view_pid == 0) {
+            exec_with_board_args(args->view_bin, board_width, board_height, env.envp, "Error: failed to exec view");
+        }
+    }
+    const char *view_bin = view_pid > 0 ? args->view_bin : NULL;
+
+    pipe_info_t *pipes = calloc(num_players, sizeof(*pipes));
+    if (!pipes) {
+        perror("Error: could not allocate player pipes");
+        rc = ERROR_PIPE;
+    }
+    match_t m = { .game = &game, .sync = sync, .pipes = pipes, .num_players = pipes ? num_players : 0,
+                  .view_bin = view_bin, .view_async = args->view_fps > 0, .delay_ms = args->delay_ms, .timeout_s = args->timeout_s,
+                  .batch_moves = args->batch_moves, .rings = rings, .stats = stats,
+                  .reach = reach_ok ? &reach : NULL, .pool = args->pool, .turn_ms = args->turn_ms };
+#if CHOMP_LATENCY
+    m.lat = lat_table_create(m.num_players);
+#endif
+    for (unsigned i = 0; i < m.num_players; i++) {
+        pipes[i].read_fd = -1;
+        pipes[i].ring = rings ? &rings->rings[i] : NULL;
+        pipes[i].stats = stats ? &stats->players[i] : NULL;
+    }
+    if (rc == SUCCESS && args->pool)
+        rc = spawn_pooled(args, &m, state_name, sync_name, moves_name, stats_name);
+    else if (rc == SUCCESS)
+        rc = spawn_players(args, &m, env.envp);
+
+    recorder_t recorder;
+    // La grabación guarda la semilla en lugar del tablero, las posiciones de place_players y los
+    // nombres; se abre antes del primer turno
+    if (rc == SUCCESS && args->record_path) {
+        record_header_t header = { .magic = RECORD_MAGIC, .version = RECORD_VERSION,
+                                   .width = (uint16_t)board_width, .height = (uint16_t)board_height,
+                                   .num_players = num_players, .seed = args->seed,
+                                   .board_format = args->board_format, .board_gen = args->board_gen };
+        if (recorder_open(&recorder, args->record_path, &header, gs, game.extra_players) == -1)
+            perror("Error: could not create game recording");
+        else
+            m.rec = &recorder;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (rc == SUCCESS) {
+        for (unsigned i = 0; i < num_players; i++)
+            give_turn(&m, i);
+
+        notify_view(&m);
+        play(&m);
+    } else {
+        finish(&m);
+    }
+    // Sin contar la espera a que se cierre la vista
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (m.rec && recorder_close(m.rec, gs, game.extra_players) == -1)
+        fprintf(stderr, "Error: game recording %s is incomplete\n", args->record_path);
+
+    if (collect_results(&m, view_pid, result) == -1 && rc == SUCCESS) {
+        perror("Error: could not allocate game results");
+        rc = ERROR_SHM;
+    }
+    result->duration_us = elapsed_us(&start, &end);
+    result->moves_applied = m.moves_applied;
+    result->move_locks = m.move_locks;
+    result->turns_timed = m.rtt_count;
+    result->turn_rtt_avg_ns = m.rtt_count ? (long)(m.rtt_sum_ns / m.rtt_count) : 0;
+    result->latency = m.lat;
+    result->decided = m.decided;
+    result->turns_forfeited = m.forfeits;
+
+    free(pipes);
+    free(m.deadlines);
+    game_untrack_neighbors(&game);
+    if (reach_ok)
+        reach_free(&reach);
+    if (moves_shm)
+        move_rings_unmap_destroy(moves_shm);
+    if (stats_shm)
+        game_stats_unmap_destroy(stats_shm);
+    game_state_unmap_destroy(game_state_shm);
+    game_sync_unmap_destroy(game_sync_shm);
+    child_env_free(&env);
+    return rc;
+}
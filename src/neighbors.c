@@ -0,0 +1,277 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <stddef.h>
+
+#include "common.h"
+#include "neighbors.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NEIGHBORS_X86 1
+#include <immintrin.h>
+#endif
+
+// Desplazamientos en el orden de direction_t (los mismos de get_direction_offset)
+static const int dir_dx[NUM_DIRECTIONS] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static const int dir_dy[NUM_DIRECTIONS] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+static const char *impl_names[NEIGHBORS_IMPLS] = { "scalar", "sse4.1", "avx2" };
+
+bool neighbors_impl_supported(neighbors_impl_t impl) {
+    switch (impl) {
+    case NEIGHBORS_SCALAR:
+        return true;
+#ifdef NEIGHBORS_X86
+    case NEIGHBORS_SSE41:
+        return __builtin_cpu_supports("sse4.1");
+    case NEIGHBORS_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+neighbors_impl_t neighbors_best_impl(void) {
+    if (neighbors_impl_supported(NEIGHBORS_AVX2))
+        return NEIGHBORS_AVX2;
+    if (neighbors_impl_supported(NEIGHBORS_SSE41))
+        return NEIGHBORS_SSE41;
+    return NEIGHBORS_SCALAR;
+}
+
+const char *neighbors_impl_name(neighbors_impl_t impl) {
+    return impl < NEIGHBORS_IMPLS ? impl_names[impl] : "?";
+}
+
+// Sin saltos: en un tablero real libres y ocupadas se mezclan sin patrón
+static inline int free_value(int v) {
+    return (unsigned)(v - MIN_REWARD) <= (unsigned)(MAX_REWARD - MIN_REWARD) ? v : 0;
+}
+
+static inline bool is_interior(int x, int y, int width, int height) {
+    return x >= 1 && x <= width - 2 && y >= 1 && y <= height - 2;
+}
+
+void neighbors_gather(const int board[], int width, int height, int x, int y, int out[NUM_DIRECTIONS]) {
+    if (is_interior(x, y, width, height)) {
+        const int *c = board + idx(x, y, width);
+        for (int d = 0; d < NUM_DIRECTIONS; d++)
+            out[d] = free_value(c[dir_dy[d] * width + dir_dx[d]]);
+        return;
+    }
+    for (int d = 0; d < NUM_DIRECTIONS; d++) {
+        int nx = x + dir_dx[d], ny = y + dir_dy[d];
+        out[d] = is_inside(nx, ny, width, height) ? free_value(board[idx(nx, ny, width)]) : 0;
+    }
+}
+
+static int best_of(const int v[NUM_DIRECTIONS], int *free_count) {
+    int best = 0, dir = -1, count = 0;
+    for (int d = 0; d < NUM_DIRECTIONS; d++) {
+        count += v[d] > 0;
+        if (v[d] > best) {
+            best = v[d];
+            dir = d;
+        }
+    }
+    if (free_count)
+        *free_count = count;
+    return dir;
+}
+
+#ifdef NEIGHBORS_X86
+// Los 8 vecinos de una celda interior con un solo gather
+__attribute__((target("avx2")))
+static int best_dir_avx2(const int *board, int width, int x, int y, int *free_count) {
+    const int *c = board + idx(x, y, width);
+    __m256i off = _mm256_setr_epi32(-width, -width + 1, 1, width + 1, width, width - 1, -1, -width - 1);
+    __m256i v = _mm256_i32gather_epi32(c, off, 4);
+    __m256i free = _mm256_and_si256(_mm256_cmpgt_epi32(v, _mm256_setzero_si256()),
+                                    _mm256_cmpgt_epi32(_mm256_set1_epi32(MAX_REWARD + 1), v));
+    v = _mm256_and_si256(v, free);
+    __m256i m = _mm256_max_epi32(v, _mm256_permute2x128_si256(v, v, 1));
+    m = _mm256_max_epi32(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm256_max_epi32(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    if (free_count)
+        *free_count = __builtin_popcount((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(free)));
+    if (_mm256_cvtsi256_si32(m) == 0)
+        return -1;
+    unsigned eq = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, m)));
+    return __builtin_ctz(eq);
+}
+
+// Sin gather: se arman dos vectores (direcciones 0-3 y 4-7) y el resto es igual
+__attribute__((target("sse4.1")))
+static int best_dir_sse41(const int *board, int width, int x, int y, int *free_count) {
+    const int *c = board + idx(x, y, width);
+    __m128i a = _mm_setr_epi32(c[-width], c[-width + 1], c[1], c[width + 1]);
+    __m128i b = _mm_setr_epi32(c[width], c[width - 1], c[-1], c[-width - 1]);
+    __m128i zero = _mm_setzero_si128(), lim = _mm_set1_epi32(MAX_REWARD + 1);
+    __m128i fa = _mm_and_si128(_mm_cmpgt_epi32(a, zero), _mm_cmplt_epi32(a, lim));
+    __m128i fb = _mm_and_si128(_mm_cmpgt_epi32(b, zero), _mm_cmplt_epi32(b, lim));
+    a = _mm_and_si128(a, fa);
+    b = _mm_and_si128(b, fb);
+    __m128i m = _mm_max_epi32(a, b);
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    if (free_count) {
+        unsigned f = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(fa)) | (unsigned)_mm_movemask_ps(_mm_castsi128_ps(fb)) << 4;
+        *free_count = __builtin_popcount(f);
+    }
+    if (_mm_cvtsi128_si32(m) == 0)
+        return -1;
+    unsigned eq = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, m))) |
+                  (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(b, m))) << 4;
+    return __builtin_ctz(eq);
+}
+#endif
+
+int neighbors_best_dir(neighbors_impl_t impl, const int board[], int width, int height, int x, int y, int *free_count) {
+#ifdef NEIGHBORS_X86
+    if (is_interior(x, y, width, height)) {
+        if (impl == NEIGHBORS_AVX2 && neighbors_impl_supported(NEIGHBORS_AVX2))
+            return best_dir_avx2(board, width, x, y, free_count);
+        if (impl == NEIGHBORS_SSE41 && neighbors_impl_supported(NEIGHBORS_SSE41))
+            return best_dir_sse41(board, width, x, y, free_count);
+    }
+#else
+    (void)impl;
+#endif
+    int v[NUM_DIRECTIONS];
+    neighbors_gather(board, width, height, x, y, v);
+    return best_of(v, free_count);
+}
+
+static void map_cell(const int board[], int width, int height, int x, int y, uint8_t *best, uint8_t *free_count) {
+    int v[NUM_DIRECTIONS];
+    neighbors_gather(board, width, height, x, y, v);
+    int b = 0, n = 0;
+    for (int d = 0; d < NUM_DIRECTIONS; d++) {
+        b = v[d] > b ? v[d] : b;
+        n += v[d] > 0;
+    }
+    best[idx(x, y, width)] = (uint8_t)b;
+    free_count[idx(x, y, width)] = (uint8_t)n;
+}
+
+#ifdef NEIGHBORS_X86
+__attribute__((target("avx2")))
+static inline void accumulate_avx2(const int *p, __m256i *best, __m256i *count) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    __m256i free = _mm256_and_si256(_mm256_cmpgt_epi32(v, _mm256_setzero_si256()),
+                                    _mm256_cmpgt_epi32(_mm256_set1_epi32(MAX_REWARD + 1), v));
+    *best = _mm256_max_epi32(*best, _mm256_and_si256(v, free));
+    *count = _mm256_sub_epi32(*count, free);
+}
+
+__attribute__((target("avx2")))
+static void store8_avx2(__m256i v, uint8_t *dst) {
+    __m128i p16 = _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    _mm_storel_epi64((__m128i *)dst, _mm_packus_epi16(p16, p16));
+}
+
+// Celdas interiores de la fila y de a 8; devuelve la primera x que no procesó
+__attribute__((target("avx2")))
+static int map_row_avx2(const int board[], int width, int y, uint8_t *best, uint8_t *free_count) {
+    const int *up = board + (size_t)(y - 1) * width, *mid = up + width, *down = mid + width;
+    int x = 1;
+    for (; x + 8 <= width - 1; x += 8) {
+        __m256i b = _mm256_setzero_si256(), n = _mm256_setzero_si256();
+        accumulate_avx2(up + x - 1, &b, &n);
+        accumulate_avx2(up + x, &b, &n);
+        accumulate_avx2(up + x + 1, &b, &n);
+        accumulate_avx2(mid + x - 1, &b, &n);
+        accumulate_avx2(mid + x + 1, &b, &n);
+        accumulate_avx2(down + x - 1, &b, &n);
+        accumulate_avx2(down + x, &b, &n);
+        accumulate_avx2(down + x + 1, &b, &n);
+        store8_avx2(b, best + (size_t)y * width + x);
+        store8_avx2(n, free_count + (size_t)y * width + x);
+    }
+    return x;
+}
+
+__attribute__((target("sse4.1")))
+static inline void accumulate_sse41(const int *p, __m128i *best, __m128i *count) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i free = _mm_and_si128(_mm_cmpgt_epi32(v, _mm_setzero_si128()),
+                                 _mm_cmplt_epi32(v, _mm_set1_epi32(MAX_REWARD + 1)));
+    *best = _mm_max_epi32(*best, _mm_and_si128(v, free));
+    *count = _mm_sub_epi32(*count, free);
+}
+
+__attribute__((target("sse4.1")))
+static void store4_sse41(__m128i v, uint8_t *dst) {
+    __m128i p16 = _mm_packs_epi32(v, v);
+    int packed = _mm_cvtsi128_si32(_mm_packus_epi16(p16, p16));
+    __builtin_memcpy(dst, &packed, 4);
+}
+
+__attribute__((target("sse4.1")))
+static int map_row_sse41(const int board[], int width, int y, uint8_t *best, uint8_t *free_count) {
+    const int *up = board + (size_t)(y - 1) * width, *mid = up + width, *down = mid + width;
+    int x = 1;
+    for (; x + 4 <= width - 1; x += 4) {
+        __m128i b = _mm_setzero_si128(), n = _mm_setzero_si128();
+        accumulate_sse41(up + x - 1, &b, &n);
+        accumulate_sse41(up + x, &b, &n);
+        accumulate_sse41(up + x + 1, &b, &n);
+        accumulate_sse41(mid + x - 1, &b, &n);
+        accumulate_sse41(mid + x + 1, &b, &n);
+        accumulate_sse41(down + x - 1, &b, &n);
+        accumulate_sse41(down + x, &b, &n);
+        accumulate_sse41(down + x + 1, &b, &n);
+        store4_sse41(b, best + (size_t)y * width + x);
+        store4_sse41(n, free_count + (size_t)y * width + x);
+    }
+    return x;
+}
+#endif
+
+// Versión escalar de una fila interior, sin comparar coordenadas
+static int map_row_scalar(const int board[], int width, int y, int x, uint8_t *best, uint8_t *free_count) {
+    const int *up = board + (size_t)(y - 1) * width, *mid = up + width, *down = mid + width;
+    for (; x <= width - 2; x++) {
+        int v[NUM_DIRECTIONS] = {
+            free_value(up[x]), free_value(up[x + 1]), free_value(mid[x + 1]), free_value(down[x + 1]),
+            free_value(down[x]), free_value(down[x - 1]), free_value(mid[x - 1]), free_value(up[x - 1])
+        };
+        int b = 0, n = 0;
+        for (int d = 0; d < NUM_DIRECTIONS; d++) {
+            b = v[d] > b ? v[d] : b;
+            n += v[d] > 0;
+        }
+        best[(size_t)y * width + x] = (uint8_t)b;
+        free_count[(size_t)y * width + x] = (uint8_t)n;
+    }
+    return x;
+}
+
+void neighbors_map(neighbors_impl_t impl, const int board[], int width, int height, uint8_t *best, uint8_t *free_count) {
+    if (!neighbors_impl_supported(impl))
+        impl = NEIGHBORS_SCALAR;
+    for (int y = 0; y < height; y++) {
+        if (y == 0 || y == height - 1 || width < 3) {
+            for (int x = 0; x < width; x++)
+                map_cell(board, width, height, x, y, best, free_count);
+            continue;
+        }
+        map_cell(board, width, height, 0, y, best, free_count);
+        int x = 1;
+#ifdef NEIGHBORS_X86
+        if (impl == NEIGHBORS_AVX2)
+            x = map_row_avx2(board, width, y, best, free_count);
+        else if (impl == NEIGHBORS_SSE41)
+            x = map_row_sse41(board, width, y, best, free_count);
+#endif
+        map_row_scalar(board, width, y, x, best, free_count);
+        map_cell(board, width, height, width - 1, y, best, free_count);
+    }
+}
+
+// El vecino libre de mayor recompensa. Para una sola celda conviene SSE4.1: el gather de AVX2
+// cuesta más que armar los dos vectores a mano (ver bench/bench_neighbors.c)
+int pick_dir(const int board[], int width, int height, int x, int y) {
+    return neighbors_best_dir(NEIGHBORS_SSE41, board, width, height, x, y, NULL);
+}
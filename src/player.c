@@ -1,7 +1,7 @@
 // This is a personal academic project. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
 
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -9,77 +9,80 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <string.h>
+#include <time.h>
 
 #include "common.h"
 #include "shm.h"
 #include "reader_sync.h"
 #include "player.h"
+#include "board_mirror.h"
+#include "move_ring.h"
+#include "search.h"
+#include "neighbors.h"
+#include "stats.h"
 
-int pick_dir(int board[], int width, int height, int x, int y) {
-    int max_score = 0;
-    int dir = -1;
-    for (direction_t d = 0; d < NUM_DIRECTIONS; d++) {
-        int dx, dy;
-        get_direction_offset(d, &dx, &dy);
-        if (is_inside(x+dx, y+dy, width, height)) {
-            int current_score = board[idx(x+dx, y+dy, width)];
-            
-            if (current_score > max_score) {
-                max_score = current_score;
-                dir = d;
-            }
-        }
-    }
-    return dir;
-}
+// make bin/player_<nombre>: el plugin plugins/<nombre>.c enlazado como estrategia por defecto
+#ifdef CHOMP_PLUGIN_STATIC
+#include "plugin.h"
+extern const chomp_plugin_t chomp_plugin;
+#endif
 
-int find_player_index(game_state_t *game_state, game_sync_t *sync, pid_t me) {
-    int idx = -1;
-    reader_enter(sync);
-    for (unsigned i = 0; i < game_state->num_players; i++) {
-        if (game_state->players[i].pid == me) {
-            idx = (int)i;
-            break;
+int find_player_index(game_state_t *game_state, const player_t *extra, game_sync_t *sync, read_protocol_t protocol, pid_t me) {
+    int idx;
+    unsigned t;
+    do {
+        t = snapshot_begin(sync, protocol);
+        idx = -1;
+        unsigned n = game_state->num_players;
+        if (!extra && n > MAX_PLAYERS)
+            n = MAX_PLAYERS;
+        for (unsigned i = 0; i < n; i++) {
+            if (game_player_ro(game_state, extra, i)->pid == me) {
+                idx = (int)i;
+                break;
+            }
         }
-    }
-    reader_exit(sync);
+    } while (!snapshot_end(sync, protocol, t));
     return idx;
 }
 
 int init_shared_memory(int width, int height, shm_adt *state_h, shm_adt *sync_h, game_state_t **game_state, game_sync_t **sync) {
-    if (shm_region_open_readonly(state_h, SHM_STATE, game_state_size(width, height)) == -1)
-        return ERROR_SHM_ATTACH;
-    if (shm_region_open(sync_h, SHM_SYNC, sizeof(game_sync_t)) == -1)
+    if (shm_region_open_readonly(state_h, shm_region_name(ENV_SHM_STATE, SHM_STATE), game_state_size(width, height, BOARD_FORMAT_INT)) == -1)
         return ERROR_SHM_ATTACH;
-    if (game_state_map_readonly(*state_h, (unsigned short)width, (unsigned short)height, game_state) == -1)
+    if (shm_region_open(sync_h, shm_region_name(ENV_SHM_SYNC, SHM_SYNC), sizeof(game_sync_t)) == -1)
         return ERROR_SHM_ATTACH;
+    // Primero sync: indica con qué opciones mapeó el master el estado
     if (game_sync_map(*sync_h, sync) == -1)
         return ERROR_SHM_ATTACH;
+    if (game_state_map_readonly(*state_h, (unsigned short)width, (unsigned short)height,
+                                game_sync_board_format(*sync_h), game_sync_state_map_opts(*sync_h), game_state) == -1)
+        return ERROR_SHM_ATTACH;
     return SUCCESS;
 }
 
-int is_game_finished(game_state_t *game_state, game_sync_t *sync) {
-    reader_enter(sync);
-    int finished = game_state->game_finished;
-    reader_exit(sync);
+int is_game_finished(game_state_t *game_state, game_sync_t *sync, read_protocol_t protocol) {
+    int finished;
+    unsigned t;
+    do {
+        t = snapshot_begin(sync, protocol);
+        finished = game_state->game_finished;
+    } while (!snapshot_end(sync, protocol, t));
     return finished;
 }
 
-void get_player_position(game_state_t *game_state, game_sync_t *sync, int my_idx, int *x, int *y) {
-    reader_enter(sync);
-    *x = game_state->players[my_idx].x;
-    *y = game_state->players[my_idx].y;
-    reader_exit(sync);
+void get_player_position(const player_t *me, game_sync_t *sync, read_protocol_t protocol, int *x, int *y) {
+    unsigned t;
+    do {
+        t = snapshot_begin(sync, protocol);
+        *x = me->x;
+        *y = me->y;
+    } while (!snapshot_end(sync, protocol, t));
 }
 
 
-int main(int argc, char * argv[]){
-    if (argc<NUM_ARGS){ 
-        fprintf(stderr,"uso: jugador <W> <H>\n"); 
-        return ERROR_INVALID_ARGS; 
-    }
-    int width = atoi(argv[1]), height = atoi(argv[2]);
-
+// Una partida completa; en el pool (pooled) el jugador no cierra stdout al quedar bloqueado,
+// espera a que el master anuncie el fin como cualquier otro
+static int play_game(int width, int height, bool pooled) {
     shm_adt state_h, sync_h;
     game_state_t *game_state = NULL;
     game_sync_t *sync = NULL;
@@ -88,38 +91,128 @@ int main(int argc, char * argv[]){
         return ERROR_SHM_ATTACH;
     }
 
+    read_protocol_t protocol = game_sync_read_protocol(sync_h);
     pid_t me = getpid();
-    int my_idx = find_player_index(game_state, sync, me);
+    const player_t *extra = game_state_extra_players(state_h, sync_h, (unsigned short)width, (unsigned short)height);
+    int my_idx = find_player_index(game_state, extra, sync, protocol, me);
     if (my_idx<0){ 
         fprintf(stderr,"jugador: no encuentro mi PID en game_state\n"); 
         return 2; 
     }
+    const player_t *my_player = game_player_ro(game_state, extra, (unsigned)my_idx);
+    sem_t *my_turn = player_sem(sync, (unsigned)my_idx);
 
-    int * board_copy = malloc(width * height * sizeof(*board_copy));
-    if (!board_copy) {
-    perror("Error: failed to allocate memory for board_copy");
+    // Con el transporte en anillo los movimientos van a la región de movimientos en vez de a stdout
+    shm_adt moves_h = NULL;
+    move_rings_t *rings = NULL;
+    if (game_sync_move_transport(sync_h) == MOVE_TRANSPORT_RING &&
+        (shm_region_open(&moves_h, shm_region_name(ENV_SHM_MOVES, SHM_MOVES), move_rings_size((unsigned)my_idx + 1)) == -1 ||
+         move_rings_map(moves_h, (unsigned)my_idx + 1, &rings) == -1)) {
+        perror("Error: failed to attach move ring");
+        return ERROR_SHM_ATTACH;
+    }
+
+    // Contadores propios en la región de estadísticas, solo si el master pasó su nombre
+    shm_adt stats_h = NULL;
+    game_stats_t *stats = NULL;
+    game_stats_player_t *my_stats = NULL;
+    const char *stats_name = getenv(ENV_SHM_STATS);
+    if (stats_name && stats_name[0] == '/' && shm_region_open_existing(&stats_h, stats_name) == 0) {
+        if (game_stats_map(stats_h, (unsigned)my_idx + 1, &stats) == 0) {
+            my_stats = &stats->players[my_idx];
+        } else {
+            game_stats_unmap_destroy(stats_h);
+            stats_h = NULL;
+        }
+    }
+
+    // Con CHOMP_STRATEGY=search se busca con lookahead en lugar de pick_dir
+    search_t *search = NULL;
+    search_player_t *players = NULL;
+    unsigned num_players = extra ? MAX_PLAYERS_EXT : MAX_PLAYERS;
+    const char *strategy = getenv(ENV_PLAYER_STRATEGY);
+    if (strategy && !strcmp(strategy, "search")) {
+        search_config_t cfg = search_config_from_env();
+        search = search_create(&cfg);
+        players = calloc(num_players, sizeof(*players));
+        if (!search || !players) {
+            perror("Error: failed to allocate search");
+            return ERROR_SHM_ATTACH;
+        }
+    }
+
+#ifdef CHOMP_PLUGIN_STATIC
+    void *plugin_ctx = chomp_plugin.create ? chomp_plugin.create(width, height, (unsigned)my_idx) : NULL;
+#endif
+
+    board_mirror_t mirror;
+    if (board_mirror_init(&mirror, width, height, game_sync_board_format(sync_h), game_state_delta_log(state_h, sync_h, (unsigned short)width, (unsigned short)height)) == -1) {
+        perror("Error: failed to allocate memory for board_copy");
         game_state_unmap_destroy(state_h);
         game_sync_unmap_destroy(sync_h);
         return ERROR_SHM_ATTACH;
     }
 
     while (1) {
-        sem_wait(&sync->player_ready[my_idx]);
-        if (is_game_finished(game_state, sync))
+        sem_wait(my_turn);
+        if (is_game_finished(game_state, sync, protocol))
             break;
 
-        reader_enter(sync);
-        int x = game_state->players[my_idx].x;
-        int y = game_state->players[my_idx].y;
-        memcpy(board_copy, game_state->board, width * height * sizeof(*board_copy));
-        reader_exit(sync);
+        // Solo se copian los cambios desde el turno anterior (o el tablero entero si no hay log)
+        int x, y;
+        unsigned t, attempts = 0;
+        do {
+            attempts++;
+            t = snapshot_begin(sync, protocol);
+            x = my_player->x;
+            y = my_player->y;
+            board_mirror_read(&mirror, game_state);
+            if (search) {
+                num_players = game_state->num_players;
+                if (num_players > (extra ? MAX_PLAYERS_EXT : MAX_PLAYERS))
+                    num_players = extra ? MAX_PLAYERS_EXT : MAX_PLAYERS;
+                for (unsigned i = 0; i < num_players; i++) {
+                    const player_t *p = game_player_ro(game_state, extra, i);
+                    players[i].x = p->x;
+                    players[i].y = p->y;
+                    players[i].blocked = p->is_blocked;
+                }
+            }
+        } while (!snapshot_end(sync, protocol, t));
+        board_mirror_commit(&mirror);
 
-        int dir = pick_dir(board_copy, width, height, x, y);
+        struct timespec think_start, think_end;
+        if (my_stats)
+            clock_gettime(CLOCK_MONOTONIC, &think_start);
+        int dir;
+        if (search) {
+            players[my_idx].x = (unsigned short)x;
+            players[my_idx].y = (unsigned short)y;
+            dir = search_pick_dir(search, mirror.board, width, height, players, num_players, (unsigned)my_idx);
+        } else {
+#ifdef CHOMP_PLUGIN_STATIC
+            dir = chomp_plugin.pick_dir(mirror.board, width, height, x, y, plugin_ctx);
+#else
+            dir = pick_dir(mirror.board, width, height, x, y);
+#endif
+        }
+        if (my_stats) {
+            clock_gettime(CLOCK_MONOTONIC, &think_end);
+            stats_add(&my_stats->think_ns, (uint64_t)((think_end.tv_sec - think_start.tv_sec) * 1000000000LL +
+                                                      (think_end.tv_nsec - think_start.tv_nsec)));
+            stats_add(&my_stats->snapshot_retries, attempts - 1);
+            if (dir >= 0)
+                stats_add(&my_stats->turns, 1);
+        }
 
-        if (dir < 0) {
+        if (dir < 0 && pooled) {
+            continue;
+        } else if (dir < 0) {
             fflush(stdout);
             close(STDOUT_FILENO);
             break;
+        } else if (rings) {
+            move_ring_push(rings, (unsigned)my_idx, (unsigned char)dir);
         } else {
             unsigned char b = (unsigned char)dir;
             if (write(STDOUT_FILENO, &b, 1) < 0) 
@@ -129,9 +222,55 @@ int main(int argc, char * argv[]){
         
     }
 
+    if (rings) {
+        move_ring_close(rings, (unsigned)my_idx);
+        move_rings_unmap_destroy(moves_h);
+    }
+    if (stats_h)
+        game_stats_unmap_destroy(stats_h);
     game_state_unmap_destroy(state_h);
     game_sync_unmap_destroy(sync_h);
-    free(board_copy);
+    board_mirror_free(&mirror);
+#ifdef CHOMP_PLUGIN_STATIC
+    if (plugin_ctx && chomp_plugin.destroy)
+        chomp_plugin.destroy(plugin_ctx);
+#endif
+    search_destroy(search);
+    free(players);
     return SUCCESS;
 }
 
+// Modo pool: una partida por línea de stdin, hasta que el master la cierre. Los nombres de las
+// regiones pasan por el entorno como si los hubiera puesto el master al lanzarlo
+static int serve_pool(void) {
+    char line[POOL_LINE_MAX];
+    while (fgets(line, sizeof line, stdin)) {
+        int width, height;
+        char state[POOL_LINE_MAX], sync[POOL_LINE_MAX], moves[POOL_LINE_MAX], stats[POOL_LINE_MAX];
+        if (sscanf(line, "%d %d %s %s %s %s", &width, &height, state, sync, moves, stats) != 6) {
+            fprintf(stderr, "jugador: línea de partida inválida\n");
+            return ERROR_INVALID_ARGS;
+        }
+        setenv(ENV_SHM_STATE, state, 1);
+        setenv(ENV_SHM_SYNC, sync, 1);
+        setenv(ENV_SHM_MOVES, moves, 1);
+        setenv(ENV_SHM_STATS, stats, 1);
+        int rc = play_game(width, height, true);
+        if (rc != SUCCESS)
+            return rc; // el master ve el EOF y saca al jugador del pool
+        unsigned char done = POOL_GAME_DONE;
+        if (write(STDOUT_FILENO, &done, 1) != 1)
+            return SUCCESS;
+    }
+    return SUCCESS;
+}
+
+int main(int argc, char * argv[]){
+    if (getenv(ENV_PLAYER_POOL))
+        return serve_pool();
+    if (argc<NUM_ARGS){ 
+        fprintf(stderr,"uso: jugador <W> <H>\n"); 
+        return ERROR_INVALID_ARGS; 
+    }
+    return play_game(atoi(argv[1]), atoi(argv[2]), false);
+}
@@ -0,0 +1,268 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+// Partidas con los jugadores como plugins: se cargan con dlopen y juegan en el proceso del master
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dlfcn.h>
+
+#include "common.h"
+#include "game.h"
+#include "match.h"
+#include "plugin.h"
+#include "record.h"
+#include "reach.h"
+
+struct plugin {
+    void *handle;
+    const chomp_plugin_t *api;
+};
+
+static bool is_plugin_path(const char *path) {
+    size_t len = strlen(path), suffix = strlen(CHOMP_PLUGIN_SUFFIX);
+    return len > suffix && !strcmp(path + len - suffix, CHOMP_PLUGIN_SUFFIX);
+}
+
+static plugin_t *plugin_load(const char *path) {
+    plugin_t *p = calloc(1, sizeof(*p));
+    if (!p) {
+        perror("Error: could not allocate plugin");
+        return NULL;
+    }
+    p->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!p->handle) {
+        fprintf(stderr, "Error: could not load plugin: %s\n", dlerror());
+        free(p);
+        return NULL;
+    }
+    p->api = dlsym(p->handle, CHOMP_PLUGIN_SYMBOL);
+    if (!p->api || p->api->abi != CHOMP_PLUGIN_ABI || !p->api->pick_dir) {
+        fprintf(stderr, "Error: %s does not export a " CHOMP_PLUGIN_SYMBOL " with ABI %d\n", path, CHOMP_PLUGIN_ABI);
+        dlclose(p->handle);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+int plugins_load(char **paths, unsigned num_players, plugin_t ***plugins) {
+    unsigned found = 0;
+    for (unsigned i = 0; i < num_players; i++)
+        found += is_plugin_path(paths[i]);
+    *plugins = NULL;
+    if (found == 0)
+        return 0;
+    if (found != num_players) {
+        fprintf(stderr, "Error: plugins (" CHOMP_PLUGIN_SUFFIX ") and player executables cannot be mixed\n");
+        return -1;
+    }
+    plugin_t **loaded = calloc(num_players, sizeof(*loaded));
+    if (!loaded) {
+        perror("Error: could not allocate plugins");
+        return -1;
+    }
+    for (unsigned i = 0; i < num_players; i++) {
+        if (!(loaded[i] = plugin_load(paths[i]))) {
+            plugins_unload(loaded, i);
+            return -1;
+        }
+    }
+    *plugins = loaded;
+    return 1;
+}
+
+void plugins_unload(plugin_t **plugins, unsigned num_players) {
+    if (!plugins)
+        return;
+    for (unsigned i = 0; i < num_players; i++) {
+        if (!plugins[i])
+            continue;
+        dlclose(plugins[i]->handle);
+        free(plugins[i]);
+    }
+    free(plugins);
+}
+
+static long elapsed_us(const struct timespec *from, const struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1000000L + (to->tv_nsec - from->tv_nsec) / 1000L;
+}
+
+typedef struct {
+    game_t *game;
+    plugin_t **plugins;
+    void **ctx;
+    recorder_t *rec;
+    reach_t *reach;
+    unsigned long moves_applied;
+    int turn_ms;                  // plazo de cada pick_dir, 0 sin plazo
+    unsigned long forfeits;
+} plugin_match_t;
+
+// Una ronda: cada jugador no bloqueado elige y mueve, empezando por first como el master con
+// procesos. Devuelve la cantidad de movimientos válidos; *changed queda en true si cambió algo
+// de lo que mira reach_decided (una captura o un jugador que se fue)
+static unsigned play_round(plugin_match_t *m, unsigned first, bool *changed) {
+    game_state_t *gs = m->game->state;
+    unsigned n = gs->num_players, valid = 0;
+    int W = gs->board_width, H = gs->board_height;
+    *changed = false;
+    for (unsigned k = 0; k < n; k++) {
+        unsigned i = (first + k) % n;
+        player_t *pl = game_player(gs, m->game->extra_players, i);
+        if (pl->is_blocked)
+            continue;
+        struct timespec t0, t1;
+        if (m->turn_ms > 0)
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+        int dir = m->plugins[i]->api->pick_dir(gs->board, W, H, pl->x, pl->y, m->ctx[i]);
+        if (m->turn_ms > 0) {
+            // Las llamadas son en serie: no se puede cortar a tiempo, pero el turno se pierde igual
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            if (elapsed_us(&t0, &t1) > m->turn_ms * 1000L) {
+                m->forfeits++;
+                continue;
+            }
+        }
+        if (dir < 0) {
+            // Como un jugador que cierra su pipe
+            block_player(m->game, i);
+            if (m->rec)
+                recorder_gone(m->rec, i);
+            *changed = true;
+            continue;
+        }
+        unsigned score_before = pl->score;
+        int was_valid = apply_move(m->game, (int)i, (unsigned char)dir);
+        if (m->rec)
+            recorder_move(m->rec, i, (unsigned char)dir);
+        m->moves_applied++;
+        if (was_valid) {
+            valid++;
+            if (m->reach) {
+                reach_capture(m->reach, m->game, idx(pl->x, pl->y, W), pl->score - score_before);
+                *changed = true;
+            }
+        }
+    }
+    return valid;
+}
+
+int run_plugin_game(const game_args_t *args, game_result_t *result) {
+    int W = args->board_width, H = args->board_height;
+    unsigned n = (unsigned)args->num_players;
+    memset(result, 0, sizeof(*result));
+    result->view_status = -1;
+
+    struct timespec map_start, map_end, init_end;
+    clock_gettime(CLOCK_MONOTONIC, &map_start);
+    game_t game = { .format = BOARD_FORMAT_INT };
+    game.state = calloc(1, game_state_size(W, H, BOARD_FORMAT_INT));
+    if (n > MAX_PLAYERS)
+        game.extra_players = calloc(extra_player_count(n), sizeof(player_t));
+    void **ctx = calloc(n, sizeof(*ctx));
+    if (!game.state || (n > MAX_PLAYERS && !game.extra_players) || !ctx) {
+        perror("Error: could not allocate game state");
+        free(game.state);
+        free(game.extra_players);
+        free(ctx);
+        return ERROR_SHM;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &map_end);
+
+    game_state_t *gs = game.state;
+    gs->board_width = (unsigned short)W;
+    gs->board_height = (unsigned short)H;
+    gs->num_players = n;
+    init_board(&game, args->seed, args->board_gen);
+    place_players(&game);
+    for (unsigned i = 0; i < n; i++)
+        snprintf(game_player(gs, game.extra_players, i)->name, MAX_NAME_LEN, "%s", args->plugins[i]->api->name);
+    if (game_track_neighbors(&game) == -1)
+        perror("Warning: could not track free neighbors, blocked players are detected only when they give up");
+    reach_t reach;
+    bool reach_ok = args->early_finish && reach_init(&reach, &game) == 0;
+    if (args->early_finish && !reach_ok)
+        perror("Warning: could not track free components, the game will not finish early");
+    clock_gettime(CLOCK_MONOTONIC, &init_end);
+    result->state_bytes = game_state_size(W, H, BOARD_FORMAT_INT) + extra_player_count(n) * sizeof(player_t);
+    result->map_us = elapsed_us(&map_start, &map_end);
+    result->init_us = elapsed_us(&map_end, &init_end);
+
+    for (unsigned i = 0; i < n; i++) {
+        const chomp_plugin_t *api = args->plugins[i]->api;
+        ctx[i] = api->create ? api->create(W, H, i) : NULL;
+    }
+
+    plugin_match_t m = { .game = &game, .plugins = args->plugins, .ctx = ctx,
+                         .reach = reach_ok ? &reach : NULL, .turn_ms = args->turn_ms };
+    recorder_t recorder;
+    if (args->record_path) {
+        record_header_t header = { .magic = RECORD_MAGIC, .version = RECORD_VERSION,
+                                   .width = (uint16_t)W, .height = (uint16_t)H,
+                                   .num_players = n, .seed = args->seed,
+                                   .board_format = BOARD_FORMAT_INT, .board_gen = args->board_gen };
+        if (recorder_open(&recorder, args->record_path, &header, gs, game.extra_players) == -1)
+            perror("Error: could not create game recording");
+        else
+            m.rec = &recorder;
+    }
+
+    // Se corta como el master: timeout_s sin movimientos válidos. El reloj solo se mira en las
+    // rondas sin ninguno
+    struct timespec start, end, stalled_since, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool stalled = false;
+    for (unsigned round = 0; game.num_blocked < n; round++) {
+        bool changed;
+        if (play_round(&m, round % n, &changed) > 0) {
+            stalled = false;
+        } else if (!stalled) {
+            stalled = true;
+            clock_gettime(CLOCK_MONOTONIC, &stalled_since);
+        } else {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (elapsed_us(&stalled_since, &now) >= args->timeout_s * 1000000L)
+                break;
+        }
+        if (m.reach && changed && reach_decided(m.reach, &game)) {
+            result->decided = true;
+            break;
+        }
+    }
+    gs->game_finished = true;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (m.rec && recorder_close(m.rec, gs, game.extra_players) == -1)
+        fprintf(stderr, "Error: game recording %s is incomplete\n", args->record_path);
+
+    int rc = SUCCESS;
+    result->num_players = n;
+    result->players = calloc(n, sizeof(player_t));
+    result->exit_codes = calloc(n, sizeof(int)); // nadie sale: todos en 0
+    if (result->players && result->exit_codes) {
+        for (unsigned i = 0; i < n; i++)
+            result->players[i] = *game_player(gs, game.extra_players, i);
+    } else {
+        perror("Error: could not allocate game results");
+        rc = ERROR_SHM;
+    }
+    result->duration_us = elapsed_us(&start, &end);
+    result->moves_applied = m.moves_applied;
+    result->turns_forfeited = m.forfeits;
+
+    for (unsigned i = 0; i < n; i++) {
+        const chomp_plugin_t *api = args->plugins[i]->api;
+        if (ctx[i] && api->destroy)
+            api->destroy(ctx[i]);
+    }
+    free(ctx);
+    game_untrack_neighbors(&game);
+    if (reach_ok)
+        reach_free(&reach);
+    free(game.state);
+    free(game.extra_players);
+    return rc;
+}
@@ -0,0 +1,257 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "game.h"
+#include "reach.h"
+
+static bool push(reach_t *r, unsigned q, size_t *len, uint32_t cell) {
+    if (*len == r->queue_cap[q]) {
+        size_t cap = r->queue_cap[q] ? 2 * r->queue_cap[q] : 1024;
+        uint32_t *grown = realloc(r->queue[q], cap * sizeof(uint32_t));
+        if (!grown)
+            return false;
+        r->queue[q] = grown;
+        r->queue_cap[q] = cap;
+    }
+    r->queue[q][(*len)++] = cell;
+    return true;
+}
+
+static uint32_t new_comp(reach_t *r) {
+    if (r->num_comps == r->cap_comps) {
+        uint32_t cap = r->cap_comps ? 2 * r->cap_comps : 256;
+        reach_comp_t *grown = realloc(r->comps, cap * sizeof(reach_comp_t));
+        if (!grown)
+            return 0;
+        r->comps = grown;
+        r->cap_comps = cap;
+    }
+    r->comps[r->num_comps] = (reach_comp_t){ 0, 0 };
+    return r->num_comps++;
+}
+
+// Próxima ronda de búsquedas; cuando la ronda no entra en los 30 bits altos se limpia mark
+static uint32_t next_round(reach_t *r) {
+    if (++r->round >= (1u << 30)) {
+        memset(r->mark, 0, (size_t)r->width * r->height * sizeof(uint32_t));
+        r->round = 1;
+    }
+    return r->round << 2;
+}
+
+int reach_init(reach_t *r, const game_t *g) {
+    memset(r, 0, sizeof(*r));
+    r->width = g->state->board_width;
+    r->height = g->state->board_height;
+    size_t cells = (size_t)r->width * r->height;
+    r->label = calloc(cells, sizeof(uint32_t));
+    r->mark = calloc(cells, sizeof(uint32_t));
+    if (!r->label || !r->mark || new_comp(r) != 0) {
+        reach_free(r);
+        return -1;
+    }
+
+    int W = r->width, H = r->height;
+    for (size_t start = 0; start < cells; start++) {
+        int v = board_get(g->state, g->format, (int)start);
+        if (!cell_is_free(v) || r->label[start])
+            continue;
+        uint32_t c = new_comp(r);
+        if (!c) {
+            reach_free(r);
+            return -1;
+        }
+        size_t len = 0, head = 0;
+        r->label[start] = c;
+        if (!push(r, 0, &len, (uint32_t)start)) {
+            reach_free(r);
+            return -1;
+        }
+        while (head < len) {
+            uint32_t cell = r->queue[0][head++];
+            r->comps[c].size++;
+            r->comps[c].reward += (uint32_t)board_get(g->state, g->format, (int)cell);
+            int x = (int)(cell % (uint32_t)W), y = (int)(cell / (uint32_t)W);
+            for (direction_t d = 0; d < NUM_DIRECTIONS; d++) {
+                int dx, dy;
+                get_direction_offset(d, &dx, &dy);
+                if (!is_inside(x + dx, y + dy, W, H))
+                    continue;
+                int n = idx(x + dx, y + dy, W);
+                if (r->label[n] || !cell_is_free(board_get(g->state, g->format, n)))
+                    continue;
+                r->label[n] = c;
+                if (!push(r, 0, &len, (uint32_t)n)) {
+                    reach_free(r);
+                    return -1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+void reach_free(reach_t *r) {
+    free(r->label);
+    free(r->mark);
+    free(r->comps);
+    for (int q = 0; q < REACH_MAX_SEARCHES; q++)
+        free(r->queue[q]);
+    memset(r, 0, sizeof(*r));
+}
+
+static unsigned find(unsigned *parent, unsigned i) {
+    while (parent[i] != i)
+        i = parent[i];
+    return i;
+}
+
+// Los grupos de seeds (celdas de la componente c) quedaron separados alrededor de la celda
+// capturada. Se recorren en paralelo, una celda por vez cada uno; dos búsquedas que se tocan
+// son la misma componente. Cuando queda una sola sin terminar, esa se queda con c y las
+// terminadas (que están cerradas: ninguna otra búsqueda puede entrar) pasan a componentes nuevas.
+// Así cada separación cuesta lo que mide la parte chica.
+static void split(reach_t *r, const game_t *g, uint32_t c, const uint32_t *seeds, unsigned k) {
+    int W = r->width, H = r->height;
+    uint32_t base = next_round(r);
+    unsigned parent[REACH_MAX_SEARCHES];
+    size_t head[REACH_MAX_SEARCHES], len[REACH_MAX_SEARCHES];
+    for (unsigned q = 0; q < k; q++) {
+        parent[q] = q;
+        head[q] = len[q] = 0;
+        r->mark[seeds[q]] = base | q;
+        if (!push(r, q, &len[q], seeds[q]))
+            return; // sin memoria: la componente queda sin partir, la cota sigue siendo válida
+    }
+
+    while (1) {
+        // Grupos sin terminar: alguna búsqueda del grupo todavía tiene celdas en la cola
+        bool open[REACH_MAX_SEARCHES] = { false };
+        unsigned open_groups = 0;
+        for (unsigned q = 0; q < k; q++) {
+            unsigned root = find(parent, q);
+            if (head[q] < len[q] && !open[root]) {
+                open[root] = true;
+                open_groups++;
+            }
+        }
+        if (open_groups <= 1)
+            break;
+
+        for (unsigned q = 0; q < k; q++) {
+            if (head[q] == len[q])
+                continue;
+            uint32_t cell = r->queue[q][head[q]++];
+            int x = (int)(cell % (uint32_t)W), y = (int)(cell / (uint32_t)W);
+            for (direction_t d = 0; d < NUM_DIRECTIONS; d++) {
+                int dx, dy;
+                get_direction_offset(d, &dx, &dy);
+                if (!is_inside(x + dx, y + dy, W, H))
+                    continue;
+                int n = idx(x + dx, y + dy, W);
+                if (r->label[n] != c)
+                    continue;
+                if ((r->mark[n] & ~3u) == base) {
+                    unsigned a = find(parent, q), b = find(parent, r->mark[n] & 3u);
+                    if (a != b)
+                        parent[a] = b;
+                    continue;
+                }
+                r->mark[n] = base | q;
+                if (!push(r, q, &len[q], (uint32_t)n))
+                    return;
+            }
+        }
+    }
+
+    // El grupo abierto (o, si terminaron todos, el último) conserva c
+    unsigned keep = find(parent, k - 1);
+    for (unsigned q = 0; q < k; q++) {
+        if (head[q] < len[q]) {
+            keep = find(parent, q);
+            break;
+        }
+    }
+    uint32_t relabeled[REACH_MAX_SEARCHES] = { 0 };
+    for (unsigned q = 0; q < k; q++) {
+        unsigned root = find(parent, q);
+        if (root == keep)
+            continue;
+        if (!relabeled[root] && !(relabeled[root] = new_comp(r)))
+            return;
+        uint32_t nc = relabeled[root];
+        for (size_t i = 0; i < len[q]; i++) {
+            uint32_t cell = r->queue[q][i];
+            uint32_t v = (uint32_t)board_get(g->state, g->format, (int)cell);
+            r->label[cell] = nc;
+            r->comps[nc].size++;
+            r->comps[nc].reward += v;
+            r->comps[c].size--;
+            r->comps[c].reward -= v;
+        }
+    }
+}
+
+void reach_capture(reach_t *r, const game_t *g, int cell, unsigned reward) {
+    uint32_t c = r->label[cell];
+    if (!c)
+        return;
+    r->label[cell] = 0;
+    r->comps[c].size--;
+    r->comps[c].reward -= reward;
+    if (r->comps[c].size == 0)
+        return;
+
+    // Vecinas libres de la misma componente, agrupadas por adyacencia entre ellas
+    int W = r->width, H = r->height;
+    int x = cell % W, y = cell / W;
+    int nx[NUM_DIRECTIONS], ny[NUM_DIRECTIONS];
+    unsigned group[NUM_DIRECTIONS], n = 0;
+    for (direction_t d = 0; d < NUM_DIRECTIONS; d++) {
+        int dx, dy;
+        get_direction_offset(d, &dx, &dy);
+        if (is_inside(x + dx, y + dy, W, H) && r->label[idx(x + dx, y + dy, W)] == c) {
+            nx[n] = x + dx;
+            ny[n] = y + dy;
+            group[n] = n;
+            n++;
+        }
+    }
+    for (unsigned i = 0; i < n; i++)
+        for (unsigned j = i + 1; j < n; j++)
+            if (abs(nx[i] - nx[j]) <= 1 && abs(ny[i] - ny[j]) <= 1) {
+                unsigned a = find(group, i), b = find(group, j);
+                if (a != b)
+                    group[a] = b;
+            }
+    uint32_t seeds[REACH_MAX_SEARCHES];
+    unsigned k = 0;
+    for (unsigned i = 0; i < n && k < REACH_MAX_SEARCHES; i++)
+        if (find(group, i) == i)
+            seeds[k++] = (uint32_t)idx(nx[i], ny[i], W);
+    if (k > 1)
+        split(r, g, c, seeds, k);
+}
+
+bool reach_decided(const reach_t *r, const game_t *g) {
+    int W = r->width, H = r->height;
+    for (unsigned i = 0; i < g->state->num_players; i++) {
+        const player_t *p = game_player(g->state, g->extra_players, i);
+        if (p->is_blocked)
+            continue;
+        for (direction_t d = 0; d < NUM_DIRECTIONS; d++) {
+            int dx, dy;
+            get_direction_offset(d, &dx, &dy);
+            if (!is_inside(p->x + dx, p->y + dy, W, H))
+                continue;
+            uint32_t c = r->label[idx(p->x + dx, p->y + dy, W)];
+            if (c && r->comps[c].reward > 0)
+                return false;
+        }
+    }
+    return true;
+}
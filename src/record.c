@@ -0,0 +1,248 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common.h"
+#include "game.h"
+#include "record.h"
+
+#define RECORD_BUF_SIZE (64 * 1024)
+#define VARINT_MAX_BYTES 10
+
+static void flush_buffer(recorder_t *r) {
+    size_t off = 0;
+    while (!r->failed && off < r->len) {
+        ssize_t n = write(r->fd, r->buf + off, r->len - off);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("Error: could not write game recording");
+            r->failed = true;
+        } else {
+            off += (size_t)n;
+        }
+    }
+    r->len = 0;
+}
+
+// Siempre deja lugar para un evento completo
+static void reserve(recorder_t *r, size_t bytes) {
+    if (r->len + bytes > r->cap)
+        flush_buffer(r);
+}
+
+static void put_varint(recorder_t *r, uint64_t v) {
+    while (v >= 0x80) {
+        r->buf[r->len++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    r->buf[r->len++] = (unsigned char)v;
+}
+
+static void put_event(recorder_t *r, unsigned player, unsigned kind) {
+    unsigned delta = (player + r->num_players - r->last_player) % r->num_players;
+    r->last_player = player;
+    reserve(r, VARINT_MAX_BYTES + 1);
+    put_varint(r, (uint64_t)delta * RECORD_KINDS + kind);
+    r->events++;
+}
+
+int recorder_open(recorder_t *r, const char *path, const record_header_t *h, const game_state_t *gs, const player_t *extra) {
+    memset(r, 0, sizeof(*r));
+    r->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (r->fd == -1)
+        return -1;
+    r->buf = malloc(RECORD_BUF_SIZE);
+    if (!r->buf) {
+        close(r->fd);
+        return -1;
+    }
+    r->cap = RECORD_BUF_SIZE;
+    r->num_players = h->num_players;
+
+    memcpy(r->buf, h, sizeof(*h));
+    r->len = sizeof(*h);
+    for (unsigned i = 0; i < h->num_players; i++) {
+        const player_t *p = game_player_ro(gs, extra, i);
+        size_t name_len = strnlen(p->name, MAX_NAME_LEN);
+        reserve(r, 3 * VARINT_MAX_BYTES + name_len);
+        put_varint(r, p->x);
+        put_varint(r, p->y);
+        put_varint(r, name_len);
+        memcpy(r->buf + r->len, p->name, name_len);
+        r->len += name_len;
+    }
+    return 0;
+}
+
+void recorder_move(recorder_t *r, unsigned player, unsigned char move) {
+    if (is_valid_direction(move)) {
+        put_event(r, player, move);
+    } else {
+        put_event(r, player, RECORD_RAW);
+        r->buf[r->len++] = move;
+    }
+}
+
+void recorder_gone(recorder_t *r, unsigned player) {
+    put_event(r, player, RECORD_GONE);
+}
+
+int recorder_close(recorder_t *r, const game_state_t *gs, const player_t *extra) {
+    put_event(r, r->last_player, RECORD_END);
+    reserve(r, VARINT_MAX_BYTES);
+    put_varint(r, r->num_players);
+    for (unsigned i = 0; i < r->num_players; i++) {
+        const player_t *p = game_player_ro(gs, extra, i);
+        reserve(r, 3 * VARINT_MAX_BYTES);
+        put_varint(r, p->score);
+        put_varint(r, p->valid_moves);
+        put_varint(r, p->invalid_moves);
+    }
+    flush_buffer(r);
+    int rc = r->failed ? -1 : 0;
+    if (close(r->fd) == -1)
+        rc = -1;
+    free(r->buf);
+    r->buf = NULL;
+    return rc;
+}
+
+static int get_varint(record_reader_t *rd, uint64_t *out) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (rd->pos >= rd->size)
+            return -1;
+        unsigned char b = rd->base[rd->pos++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *out = v;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int record_reader_open(record_reader_t *rd, const char *path) {
+    memset(rd, 0, sizeof(*rd));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(record_header_t)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    rd->size = (size_t)st.st_size;
+    void *p = mmap(NULL, rd->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return -1;
+    (void)posix_madvise(p, rd->size, POSIX_MADV_SEQUENTIAL);
+    rd->base = p;
+    memcpy(&rd->header, rd->base, sizeof(rd->header));
+    rd->pos = sizeof(rd->header);
+    const record_header_t *h = &rd->header;
+    if (memcmp(h->magic, RECORD_MAGIC, sizeof(h->magic)) != 0 || h->version != RECORD_VERSION ||
+        h->num_players < 1 || h->num_players > MAX_PLAYERS_EXT) {
+        record_reader_close(rd);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int record_reader_player(record_reader_t *rd, player_t *p) {
+    uint64_t x, y, len;
+    if (get_varint(rd, &x) == -1 || get_varint(rd, &y) == -1 || get_varint(rd, &len) == -1 ||
+        x >= rd->header.width || y >= rd->header.height || len >= MAX_NAME_LEN || rd->pos + len > rd->size)
+        return -1;
+    p->x = (unsigned short)x;
+    p->y = (unsigned short)y;
+    memcpy(p->name, rd->base + rd->pos, len);
+    p->name[len] = '\0';
+    rd->pos += len;
+    return 0;
+}
+
+int record_reader_next(record_reader_t *rd, record_event_t *ev) {
+    if (rd->pos >= rd->size)
+        return 0;
+    uint64_t code;
+    if (get_varint(rd, &code) == -1)
+        return -1;
+    uint64_t delta = code / RECORD_KINDS;
+    unsigned kind = (unsigned)(code % RECORD_KINDS);
+    unsigned n = rd->header.num_players;
+    if (delta >= n)
+        return -1;
+    ev->player = (rd->last_player + (unsigned)delta) % n;
+    ev->kind = (unsigned char)kind;
+    ev->move = (unsigned char)kind;
+    rd->last_player = ev->player;
+    if (kind == RECORD_END)
+        return 0;
+    if (kind == RECORD_RAW) {
+        if (rd->pos >= rd->size)
+            return -1;
+        ev->move = rd->base[rd->pos++];
+    }
+    return 1;
+}
+
+int record_reader_results(record_reader_t *rd, player_t *out, unsigned n) {
+    uint64_t count;
+    if (get_varint(rd, &count) == -1 || count != n)
+        return -1;
+    for (unsigned i = 0; i < n; i++) {
+        uint64_t score, valid, invalid;
+        if (get_varint(rd, &score) == -1 || get_varint(rd, &valid) == -1 || get_varint(rd, &invalid) == -1)
+            return -1;
+        out[i].score = (unsigned)score;
+        out[i].valid_moves = (unsigned)valid;
+        out[i].invalid_moves = (unsigned)invalid;
+    }
+    return 0;
+}
+
+void record_reader_close(record_reader_t *rd) {
+    if (rd->base)
+        munmap((void *)rd->base, rd->size);
+    rd->base = NULL;
+}
+
+int record_game_setup(record_reader_t *rd, game_t *g) {
+    const record_header_t *h = &rd->header;
+    game_state_t *gs = g->state;
+    gs->board_width = h->width;
+    gs->board_height = h->height;
+    gs->num_players = h->num_players;
+    gs->game_finished = false;
+    init_board(g, h->seed, (board_gen_t)h->board_gen);
+    for (unsigned i = 0; i < h->num_players; i++) {
+        player_t start;
+        if (record_reader_player(rd, &start) == -1)
+            return -1;
+        place_player_at(g, (int)i, start.x, start.y);
+        memcpy(game_player(gs, g->extra_players, i)->name, start.name, MAX_NAME_LEN);
+    }
+    return 0;
+}
+
+int record_apply(game_t *g, const record_event_t *ev) {
+    if (ev->kind == RECORD_GONE) {
+        block_player(g, ev->player);
+        return 1;
+    }
+    return apply_move(g, (int)ev->player, ev->move);
+}
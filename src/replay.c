@@ -0,0 +1,257 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+// Reproduce una partida grabada con master -r: verifica los puntajes o se la muestra a la vista
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "common.h"
+#include "shm.h"
+#include "game.h"
+#include "record.h"
+#include "writer_sync.h"
+
+typedef struct {
+    const char *path;
+    unsigned long max_events;   // reconstruir hasta este evento (0: toda la partida)
+    const char *view_bin;
+    int delay_ms;
+    int view_fps;
+} replay_args_t;
+
+// La partida reconstruida: en memoria privada, o en memoria compartida si hay vista
+typedef struct {
+    game_t game;
+    game_sync_t *sync;          // NULL sin vista
+    shm_adt state_h, sync_h;
+    pid_t view_pid;
+    char state_name[64], sync_name[64];
+} replay_t;
+
+static void die(const char *m, int error_code) {
+    puts(m);
+    exit(error_code);
+}
+
+static void usage(void) {
+    die("Usage: ./replay [-n events] [-v view] [-d delay] [-f fps] record", ERROR_INVALID_ARGS);
+}
+
+static replay_args_t parse_args(int argc, char **argv) {
+    replay_args_t args;
+    memset(&args, 0, sizeof args);
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && argc > i + 1)
+            args.max_events = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-v") && argc > i + 1)
+            args.view_bin = argv[++i];
+        else if (!strcmp(argv[i], "-d") && argc > i + 1)
+            args.delay_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-f") && argc > i + 1)
+            args.view_fps = atoi(argv[++i]);
+        else if (argv[i][0] != '-' && !args.path)
+            args.path = argv[i];
+        else
+            usage();
+    }
+    if (!args.path)
+        usage();
+    return args;
+}
+
+static double elapsed_s(const struct timespec *from, const struct timespec *to) {
+    return (double)(to->tv_sec - from->tv_sec) + (double)(to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+static int alloc_private(replay_t *r, const record_header_t *h) {
+    board_format_t format = (board_format_t)h->board_format;
+    r->game.state = calloc(1, game_state_size(h->width, h->height, format));
+    if (h->num_players > MAX_PLAYERS)
+        r->game.extra_players = calloc(extra_player_count(h->num_players), sizeof(player_t));
+    if (!r->game.state || (h->num_players > MAX_PLAYERS && !r->game.extra_players))
+        return -1;
+    return 0;
+}
+
+// Mismas regiones que arma el master, con nombres propios para no chocar con una partida en curso
+static int alloc_shared(replay_t *r, const record_header_t *h, const replay_args_t *args) {
+    board_format_t format = (board_format_t)h->board_format;
+    snprintf(r->state_name, sizeof r->state_name, "/chomp_replay_%d_state", (int)getpid());
+    snprintf(r->sync_name, sizeof r->sync_name, "/chomp_replay_%d_sync", (int)getpid());
+    if (shm_region_open(&r->state_h, r->state_name, game_state_region_size(h->width, h->height, format, h->num_players)) == -1)
+        return -1;
+    if (shm_region_open(&r->sync_h, r->sync_name, game_sync_size(h->num_players)) == -1) {
+        game_state_unmap_destroy(r->state_h);
+        return -1;
+    }
+    if (game_state_map(r->state_h, h->width, h->height, format, 0, &r->game.state) == -1 ||
+        game_sync_map(r->sync_h, &r->sync) == -1) {
+        game_state_unmap_destroy(r->state_h);
+        game_sync_unmap_destroy(r->sync_h);
+        return -1;
+    }
+    char *base = (char *)r->game.state;
+    r->game.deltas = (delta_log_t *)(base + delta_log_offset(h->width, h->height, format));
+    r->game.deltas->capacity = DELTA_LOG_CAPACITY;
+    if (h->num_players > MAX_PLAYERS)
+        r->game.extra_players = (player_t *)(base + extra_players_offset(h->width, h->height, format));
+    r->sync->read_protocol = READ_PROTOCOL_SEQLOCK;
+    r->sync->features = GAME_FEATURE_DELTA_LOG;
+    r->sync->board_format = format;
+    r->sync->view_fps = args->view_fps > 0 ? (unsigned)args->view_fps : 0;
+    return 0;
+}
+
+static void notify_view(replay_t *r) {
+    if (r->sync->view_fps) {
+        __atomic_fetch_add(&r->sync->view_generation, 1, __ATOMIC_RELEASE);
+    } else {
+        sem_post(&r->sync->view_ready);
+        sem_wait(&r->sync->view_done);
+    }
+}
+
+static void start_view(replay_t *r, const record_header_t *h, const char *view_bin) {
+    r->view_pid = fork();
+    if (r->view_pid < 0) {
+        perror("Error: could not fork view process");
+        return;
+    }
+    if (r->view_pid == 0) {
+        char wb[16], hb[16];
+        snprintf(wb, sizeof wb, "%u", h->width);
+        snprintf(hb, sizeof hb, "%u", h->height);
+        setenv(ENV_SHM_STATE, r->state_name, 1);
+        setenv(ENV_SHM_SYNC, r->sync_name, 1);
+        execl(view_bin, view_bin, wb, hb, (char *)NULL);
+        perror("Error: failed to exec view");
+        _exit(EXEC_ERROR_CODE);
+    }
+    notify_view(r);
+}
+
+static int apply_event(replay_t *r, const record_event_t *ev) {
+    if (r->sync)
+        writer_enter(r->sync);
+    int changed = record_apply(&r->game, ev);
+    if (r->sync)
+        writer_exit(r->sync);
+    return changed;
+}
+
+int main(int argc, char **argv) {
+    replay_args_t args = parse_args(argc, argv);
+
+    record_reader_t rd;
+    if (record_reader_open(&rd, args.path) == -1) {
+        perror("replay: open record");
+        return ERROR_INVALID_ARGS;
+    }
+    const record_header_t *h = &rd.header;
+    if (h->board_gen != RECORD_BOARD_GEN_RAND && h->board_gen != RECORD_BOARD_GEN_COUNTER) {
+        fprintf(stderr, "replay: unknown board generator %u\n", h->board_gen);
+        return ERROR_INVALID_ARGS;
+    }
+
+    replay_t r;
+    memset(&r, 0, sizeof r);
+    r.game.format = (board_format_t)h->board_format;
+    if ((args.view_bin ? alloc_shared(&r, h, &args) : alloc_private(&r, h)) == -1) {
+        perror("replay: could not allocate game state");
+        return ERROR_SHM;
+    }
+
+    game_state_t *gs = r.game.state;
+    if (r.sync)
+        writer_enter(r.sync);
+    int bad = record_game_setup(&rd, &r.game);
+    if (r.sync)
+        writer_exit(r.sync);
+    if (bad) {
+        fprintf(stderr, "replay: corrupt player table\n");
+        return ERROR_INVALID_ARGS;
+    }
+
+    if (args.view_bin)
+        start_view(&r, h, args.view_bin);
+    bool view = r.view_pid > 0;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long events = 0;
+    record_event_t ev;
+    int st;
+    while ((args.max_events == 0 || events < args.max_events) && (st = record_reader_next(&rd, &ev)) == 1) {
+        int changed = apply_event(&r, &ev);
+        events++;
+        if (view && changed) {
+            notify_view(&r);
+            if (args.delay_ms > 0) {
+                struct timespec ts = { .tv_sec = args.delay_ms / 1000, .tv_nsec = (args.delay_ms % 1000) * 1000000L };
+                nanosleep(&ts, NULL);
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    bool reached_end = args.max_events == 0 || events < args.max_events;
+    if (reached_end && st == -1) {
+        fprintf(stderr, "replay: corrupt record after %lu events\n", events);
+        reached_end = false;
+    }
+
+    double secs = elapsed_s(&start, &end);
+    printf("%lu events in %.3f ms (%.1f M events/s)\n", events, secs * 1e3, secs > 0 ? (double)events / secs / 1e6 : 0.0);
+
+    // Al final de la grabación están los resultados del master para comparar
+    player_t *expected = NULL;
+    if (reached_end) {
+        expected = calloc(h->num_players, sizeof(player_t));
+        if (expected && record_reader_results(&rd, expected, h->num_players) == -1) {
+            free(expected);
+            expected = NULL;
+        }
+    }
+    int mismatches = 0;
+    for (unsigned i = 0; i < h->num_players; i++) {
+        const player_t *p = game_player_ro(gs, r.game.extra_players, i);
+        printf("Player %s (%u) at (%u,%u) with a score of %u / %u / %u", p->name, i, p->x, p->y,
+               p->score, p->valid_moves, p->invalid_moves);
+        if (expected) {
+            const player_t *e = &expected[i];
+            bool ok = e->score == p->score && e->valid_moves == p->valid_moves && e->invalid_moves == p->invalid_moves;
+            if (!ok) {
+                mismatches++;
+                printf("  MISMATCH (recorded %u / %u / %u)", e->score, e->valid_moves, e->invalid_moves);
+            }
+        }
+        printf("\n");
+    }
+    if (expected)
+        printf(mismatches ? "Verification FAILED: %d players differ\n" : "Verification OK\n", mismatches);
+    else if (reached_end)
+        printf("No final results in the record (game cut short?)\n");
+
+    if (view) {
+        writer_enter(r.sync);
+        gs->game_finished = true;
+        writer_exit(r.sync);
+        notify_view(&r);
+        waitpid(r.view_pid, NULL, 0);
+    }
+    if (r.sync) {
+        game_state_unmap_destroy(r.state_h);
+        game_sync_unmap_destroy(r.sync_h);
+    } else {
+        free(r.game.state);
+        free(r.game.extra_players);
+    }
+    free(expected);
+    record_reader_close(&rd);
+    return mismatches ? 1 : SUCCESS;
+}
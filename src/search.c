@@ -0,0 +1,486 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "search.h"
+#include "territory.h"
+
+// La ventana tiene un borde de celdas ocupadas: los vecinos se miran sin comparar coordenadas
+#define STRIDE (SEARCH_SPAN + 2)
+#define WINDOW_CELLS (STRIDE * STRIDE)
+#define CENTER ((SEARCH_SPAN / 2 + 1) * STRIDE + SEARCH_SPAN / 2 + 1)
+
+#define TT_BITS 18
+#define TT_SIZE (1u << TT_BITS)
+#define NO_MOVE 15
+#define CLOCK_CHECK_MASK 63       // el thread principal mira el reloj cada 64 nodos
+#define VALUE_INF 1000000
+
+enum { TT_EXACT, TT_LOWER, TT_UPPER };
+
+// Entrada de la tabla de transposición compartida entre threads, sin locks: check = clave ^ data,
+// así una entrada escrita a medias por dos threads no valida
+typedef struct {
+    uint64_t check;
+    uint64_t data;           // valor (32) | profundidad (8) | tipo (4) | movimiento (4) | generación (16)
+} tt_entry_t;
+
+typedef struct {
+    int8_t cells[WINDOW_CELLS];   // recompensa de cada celda libre; 0 si está ocupada o fuera de la ventana
+    int pos[2];                   // celda del jugador (0) y del oponente (1); -1 si no hay oponente
+    uint64_t hash;
+    unsigned long nodes;
+    bool aborted;
+    bool horizon;                 // alguna rama llegó a profundidad 0 (buscar más hondo puede cambiar algo)
+    int best_dir;
+    unsigned depth;               // última profundidad completa
+    territory_t terr;             // la ventana en bitsets, al día con cells, para evaluar las hojas
+    unsigned id;
+    struct search *s;
+} worker_t;
+
+struct search {
+    search_config_t cfg;
+    pthread_t threads[SEARCH_MAX_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t wake;          // hay un turno nuevo (o quit)
+    pthread_cond_t finished;      // terminaron todos los threads auxiliares
+    unsigned long turn;
+    unsigned running;             // threads auxiliares que siguen buscando en este turno
+    bool quit;
+    worker_t *workers;
+    tt_entry_t *tt;
+    uint16_t generation;          // las entradas de turnos anteriores no sirven: la ventana se movió
+    struct timespec deadline;
+    int stop;
+    int8_t root_cells[WINDOW_CELLS];
+    int root_board[SEARCH_SPAN * SEARCH_SPAN];   // la misma ventana sin borde, para territory_set_board
+    int root_pos[2];
+    unsigned last_depth;
+    unsigned long last_nodes;
+};
+
+static int dir_offset[NUM_DIRECTIONS];
+static uint64_t key_cap[WINDOW_CELLS];
+static uint64_t key_pos[2][WINDOW_CELLS];
+static uint64_t key_side;
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static void init_tables(void) {
+    for (direction_t d = 0; d < NUM_DIRECTIONS; d++) {
+        int dx, dy;
+        get_direction_offset(d, &dx, &dy);
+        dir_offset[d] = dy * STRIDE + dx;
+    }
+    uint64_t seed = 0x43484d50u;
+    for (int i = 0; i < WINDOW_CELLS; i++) {
+        key_cap[i] = splitmix64(&seed);
+        key_pos[0][i] = splitmix64(&seed);
+        key_pos[1][i] = splitmix64(&seed);
+    }
+    key_side = splitmix64(&seed);
+}
+
+static bool past(const struct timespec *deadline) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+static bool out_of_time(worker_t *w) {
+    if (__atomic_load_n(&w->s->stop, __ATOMIC_RELAXED))
+        return true;
+    if (w->id == 0 && (w->nodes & CLOCK_CHECK_MASK) == 0 && past(&w->s->deadline)) {
+        __atomic_store_n(&w->s->stop, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+    return false;
+}
+
+static bool tt_probe(const struct search *s, uint64_t key, int *value, int *depth, int *flag, int *move) {
+    const tt_entry_t *e = &s->tt[key & (TT_SIZE - 1)];
+    uint64_t data = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+    if ((check ^ data) != key || (uint16_t)(data >> 48) != s->generation)
+        return false;
+    *value = (int32_t)(uint32_t)data;
+    *depth = (int)((data >> 32) & 0xff);
+    *flag = (int)((data >> 40) & 0xf);
+    *move = (int)((data >> 44) & 0xf);
+    return true;
+}
+
+static void tt_store(struct search *s, uint64_t key, int value, int depth, int flag, int move) {
+    tt_entry_t *e = &s->tt[key & (TT_SIZE - 1)];
+    uint64_t data = (uint64_t)(uint32_t)value | (uint64_t)depth << 32 | (uint64_t)flag << 40 |
+                    (uint64_t)move << 44 | (uint64_t)s->generation << 48;
+    __atomic_store_n(&e->check, key ^ data, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->data, data, __ATOMIC_RELAXED);
+}
+
+static int free_neighbors(const worker_t *w, int side) {
+    int p = w->pos[side];
+    if (p < 0)
+        return 0;
+    int n = 0;
+    for (int d = 0; d < NUM_DIRECTIONS; d++)
+        n += w->cells[p + dir_offset[d]] > 0;
+    return n;
+}
+
+static territory_source_t window_source(int p) {
+    territory_source_t src = { -1, -1 };
+    if (p >= 0) {
+        src.x = p % STRIDE - 1;
+        src.y = p / STRIDE - 1;
+    }
+    return src;
+}
+
+// Hoja: diferencia entre la recompensa del territorio de cada lado (territory_eval),
+// desde el punto de vista de side
+static int evaluate(worker_t *w, int side) {
+    territory_source_t src[2] = { window_source(w->pos[side]), window_source(w->pos[side ^ 1]) };
+    unsigned reward[2];
+    territory_eval(&w->terr, src, 2, reward, NULL);
+    return (int)reward[0] - (int)reward[1];
+}
+
+// Movimientos de side ordenados: primero el de la tabla, después por recompensa
+static int gen_moves(const worker_t *w, int side, int first, int *moves) {
+    int p = w->pos[side];
+    int n = 0;
+    for (int d = 0; d < NUM_DIRECTIONS; d++) {
+        int r = w->cells[p + dir_offset[d]];
+        if (r <= 0)
+            continue;
+        int k = n++;
+        int key = d == first ? MAX_REWARD + 1 : r;
+        while (k > 0) {
+            int prev = moves[k - 1];
+            int prev_key = prev == first ? MAX_REWARD + 1 : w->cells[p + dir_offset[prev]];
+            if (prev_key >= key)
+                break;
+            moves[k] = prev;
+            k--;
+        }
+        moves[k] = d;
+    }
+    return n;
+}
+
+// Negamax: lo que side puede sacar de ventaja (recompensas futuras propias menos las del otro).
+// Un lado sin movimientos pasa sin gastar profundidad; si ninguno puede mover, la partida terminó.
+static int negamax(worker_t *w, int side, int depth, int alpha, int beta, int *best_out) {
+    w->nodes++;
+    if (out_of_time(w)) {
+        w->aborted = true;
+        return 0;
+    }
+    int other = side ^ 1;
+    if (free_neighbors(w, side) == 0) {
+        if (free_neighbors(w, other) == 0)
+            return 0;
+        w->hash ^= key_side;
+        int v = -negamax(w, other, depth, -beta, -alpha, NULL);
+        w->hash ^= key_side;
+        return v;
+    }
+    if (depth == 0) {
+        w->horizon = true;
+        return evaluate(w, side);
+    }
+
+    uint64_t key = w->hash;
+    int alpha0 = alpha;
+    int tt_value, tt_depth, tt_flag, tt_move = NO_MOVE;
+    if (tt_probe(w->s, key, &tt_value, &tt_depth, &tt_flag, &tt_move) && !best_out && tt_depth >= depth) {
+        w->horizon = true;        // no se sabe si esa rama llegó al final: no se corta la profundización
+        if (tt_flag == TT_EXACT)
+            return tt_value;
+        if (tt_flag == TT_LOWER && tt_value > alpha)
+            alpha = tt_value;
+        else if (tt_flag == TT_UPPER && tt_value < beta)
+            beta = tt_value;
+        if (alpha >= beta)
+            return tt_value;
+    }
+
+    int moves[NUM_DIRECTIONS];
+    int n = gen_moves(w, side, tt_move, moves);
+    // Los threads auxiliares recorren la raíz en otro orden para llenar la tabla con otras ramas
+    if (best_out && w->id > 0 && n > 1) {
+        int rot = (int)(w->id % (unsigned)n), tmp[NUM_DIRECTIONS];
+        for (int i = 0; i < n; i++)
+            tmp[i] = moves[(i + rot) % n];
+        memcpy(moves, tmp, (size_t)n * sizeof(int));
+    }
+
+    int p = w->pos[side];
+    int best = -VALUE_INF, best_move = NO_MOVE;
+    for (int i = 0; i < n; i++) {
+        int d = moves[i];
+        int q = p + dir_offset[d];
+        int r = w->cells[q];
+        int qx = q % STRIDE - 1, qy = q / STRIDE - 1;
+        w->cells[q] = 0;
+        territory_set_cell(&w->terr, qx, qy, 0);
+        w->pos[side] = q;
+        w->hash ^= key_cap[q] ^ key_pos[side][p] ^ key_pos[side][q] ^ key_side;
+        int v = r - negamax(w, other, depth - 1, r - beta, r - alpha, NULL);
+        w->hash ^= key_cap[q] ^ key_pos[side][p] ^ key_pos[side][q] ^ key_side;
+        w->pos[side] = p;
+        territory_set_cell(&w->terr, qx, qy, r);
+        w->cells[q] = (int8_t)r;
+        if (w->aborted)
+            return 0;
+        if (v > best) {
+            best = v;
+            best_move = d;
+        }
+        if (v > alpha)
+            alpha = v;
+        if (alpha >= beta)
+            break;
+    }
+    int flag = best <= alpha0 ? TT_UPPER : (best >= beta ? TT_LOWER : TT_EXACT);
+    tt_store(w->s, key, best, depth, flag, best_move);
+    if (best_out)
+        *best_out = best_move;
+    return best;
+}
+
+// Profundización iterativa sobre una copia propia de la ventana
+static void run_worker(worker_t *w) {
+    struct search *s = w->s;
+    memcpy(w->cells, s->root_cells, sizeof(w->cells));
+    territory_set_board(&w->terr, s->root_board);
+    w->pos[0] = s->root_pos[0];
+    w->pos[1] = s->root_pos[1];
+    w->hash = key_pos[0][w->pos[0]] ^ (w->pos[1] >= 0 ? key_pos[1][w->pos[1]] : 0);
+    w->nodes = 0;
+    w->best_dir = -1;
+    w->depth = 0;
+    for (unsigned d = 1 + (w->id & 1); d <= SEARCH_MAX_DEPTH; d++) {
+        w->aborted = false;
+        w->horizon = false;
+        int dir = NO_MOVE;
+        negamax(w, 0, (int)d, -VALUE_INF, VALUE_INF, &dir);
+        if (w->aborted || dir == NO_MOVE)
+            break;
+        w->best_dir = dir;
+        w->depth = d;
+        if (!w->horizon)
+            break;        // se recorrió el árbol entero: el resultado es exacto
+    }
+    if (w->id == 0)
+        __atomic_store_n(&s->stop, 1, __ATOMIC_RELAXED);
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    struct search *s = w->s;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&s->lock);
+    while (1) {
+        while (s->turn == seen && !s->quit)
+            pthread_cond_wait(&s->wake, &s->lock);
+        if (s->quit)
+            break;
+        seen = s->turn;
+        pthread_mutex_unlock(&s->lock);
+        run_worker(w);
+        pthread_mutex_lock(&s->lock);
+        if (--s->running == 0)
+            pthread_cond_signal(&s->finished);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+static unsigned env_unsigned(const char *name, unsigned def) {
+    const char *v = getenv(name);
+    if (!v || !*v)
+        return def;
+    char *end;
+    unsigned long n = strtoul(v, &end, 10);
+    return *end == '\0' ? (unsigned)n : def;
+}
+
+search_config_t search_config_from_env(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    search_config_t cfg = {
+        .budget_ms = SEARCH_DEFAULT_MS,
+        .threads = cores > 4 ? 4 : (cores < 1 ? 1 : (unsigned)cores),
+    };
+    cfg.budget_ms = env_unsigned(ENV_SEARCH_MS, cfg.budget_ms);
+    cfg.threads = env_unsigned(ENV_SEARCH_THREADS, cfg.threads);
+    return cfg;
+}
+
+search_t *search_create(const search_config_t *cfg) {
+    pthread_once(&tables_once, init_tables);
+    struct search *s = calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    s->cfg = *cfg;
+    if (s->cfg.threads < 1)
+        s->cfg.threads = 1;
+    if (s->cfg.threads > SEARCH_MAX_THREADS)
+        s->cfg.threads = SEARCH_MAX_THREADS;
+    if (s->cfg.budget_ms < 1)
+        s->cfg.budget_ms = 1;
+    s->workers = calloc(s->cfg.threads, sizeof(*s->workers));
+    s->tt = calloc(TT_SIZE, sizeof(*s->tt));
+    if (!s->workers || !s->tt) {
+        free(s->workers);
+        free(s->tt);
+        free(s);
+        return NULL;
+    }
+    for (unsigned i = 0; i < s->cfg.threads; i++) {
+        s->workers[i].id = i;
+        s->workers[i].s = s;
+        if (territory_init(&s->workers[i].terr, SEARCH_SPAN, SEARCH_SPAN, 2) == -1) {
+            for (unsigned j = 0; j < i; j++)
+                territory_free(&s->workers[j].terr);
+            free(s->workers);
+            free(s->tt);
+            free(s);
+            return NULL;
+        }
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->wake, NULL);
+    pthread_cond_init(&s->finished, NULL);
+    // Si no se pueden crear todos los threads se busca con los que haya
+    unsigned created = 1;
+    while (created < s->cfg.threads &&
+           pthread_create(&s->threads[created], NULL, worker_main, &s->workers[created]) == 0)
+        created++;
+    for (unsigned i = created; i < s->cfg.threads; i++)
+        territory_free(&s->workers[i].terr);
+    s->cfg.threads = created;
+    return s;
+}
+
+void search_destroy(search_t *s) {
+    if (!s)
+        return;
+    pthread_mutex_lock(&s->lock);
+    s->quit = true;
+    pthread_cond_broadcast(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+    for (unsigned i = 1; i < s->cfg.threads; i++)
+        pthread_join(s->threads[i], NULL);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->wake);
+    pthread_cond_destroy(&s->finished);
+    for (unsigned i = 0; i < s->cfg.threads; i++)
+        territory_free(&s->workers[i].terr);
+    free(s->workers);
+    free(s->tt);
+    free(s);
+}
+
+static void build_window(struct search *s, const int board[], int width, int height,
+                         const search_player_t *players, unsigned num_players, unsigned me) {
+    int ox = players[me].x - SEARCH_SPAN / 2, oy = players[me].y - SEARCH_SPAN / 2;
+    memset(s->root_cells, 0, sizeof(s->root_cells));
+    memset(s->root_board, 0, sizeof(s->root_board));
+    for (int wy = 0; wy < SEARCH_SPAN; wy++) {
+        int by = oy + wy;
+        if (by < 0 || by >= height)
+            continue;
+        int8_t *row = &s->root_cells[(wy + 1) * STRIDE + 1];
+        for (int wx = 0; wx < SEARCH_SPAN; wx++) {
+            int bx = ox + wx;
+            if (bx >= 0 && bx < width) {
+                int v = board[idx(bx, by, width)];
+                row[wx] = (int8_t)(cell_is_free(v) ? v : 0);
+                s->root_board[idx(wx, wy, SEARCH_SPAN)] = row[wx];
+            }
+        }
+    }
+    s->root_pos[0] = CENTER;
+    s->root_pos[1] = -1;
+    int best_dist = SEARCH_SPAN / 2;
+    for (unsigned i = 0; i < num_players; i++) {
+        if (i == me || players[i].blocked)
+            continue;
+        int dx = abs((int)players[i].x - players[me].x), dy = abs((int)players[i].y - players[me].y);
+        int dist = dx > dy ? dx : dy;
+        if (dist < best_dist) {
+            best_dist = dist;
+            s->root_pos[1] = (players[i].y - oy + 1) * STRIDE + (players[i].x - ox + 1);
+        }
+    }
+}
+
+int search_pick_dir(search_t *s, const int board[], int width, int height,
+                    const search_player_t *players, unsigned num_players, unsigned me) {
+    build_window(s, board, width, height, players, num_players, me);
+    s->last_depth = 0;
+    s->last_nodes = 0;
+    int only = -1, count = 0;
+    for (int d = 0; d < NUM_DIRECTIONS; d++) {
+        if (s->root_cells[CENTER + dir_offset[d]] > 0) {
+            only = d;
+            count++;
+        }
+    }
+    if (count <= 1)
+        return only;
+
+    s->generation++;
+    s->stop = 0;
+    clock_gettime(CLOCK_MONOTONIC, &s->deadline);
+    s->deadline.tv_nsec += (long)(s->cfg.budget_ms % 1000) * 1000000L;
+    s->deadline.tv_sec += s->cfg.budget_ms / 1000 + s->deadline.tv_nsec / 1000000000L;
+    s->deadline.tv_nsec %= 1000000000L;
+
+    pthread_mutex_lock(&s->lock);
+    s->running = s->cfg.threads - 1;
+    s->turn++;
+    pthread_cond_broadcast(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+    run_worker(&s->workers[0]);
+    pthread_mutex_lock(&s->lock);
+    while (s->running > 0)
+        pthread_cond_wait(&s->finished, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+
+    // Se queda con la búsqueda más profunda; a igual profundidad, la del thread principal
+    const worker_t *best = &s->workers[0];
+    for (unsigned i = 0; i < s->cfg.threads; i++) {
+        const worker_t *w = &s->workers[i];
+        s->last_nodes += w->nodes;
+        if (w->best_dir >= 0 && (best->best_dir < 0 || w->depth > best->depth))
+            best = w;
+    }
+    s->last_depth = best->depth;
+    return best->best_dir >= 0 ? best->best_dir : only;
+}
+
+unsigned search_last_depth(const search_t *s) {
+    return s->last_depth;
+}
+
+unsigned long search_last_nodes(const search_t *s) {
+    return s->last_nodes;
+}
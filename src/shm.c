@@ -5,6 +5,7 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <time.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +13,8 @@
 
 #include "common.h"
 #include "shm.h"
+#include "move_ring.h"
+#include "stats.h"
 
 
 struct shm_cdt {
@@ -37,6 +40,63 @@ static void *map_ro(int fd, size_t sz) {
     return (p == MAP_FAILED) ? NULL : p;
 }
 
+// Mapea alineado a HUGE_PAGE_SIZE y pide páginas grandes (THP de tmpfs, según shmem_enabled)
+static void *map_huge(int fd, size_t sz, int prot) {
+    size_t resv_len = sz + HUGE_PAGE_SIZE;
+    char *resv = mmap(NULL, resv_len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (resv == MAP_FAILED)
+        return NULL;
+    char *aligned = (char *)(((size_t)resv + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+    void *p = mmap(aligned, sz, prot, MAP_SHARED | MAP_FIXED, fd, 0);
+    if (p == MAP_FAILED) {
+        munmap(resv, resv_len);
+        return NULL;
+    }
+    if (aligned > resv)
+        munmap(resv, (size_t)(aligned - resv));
+    size_t tail = (size_t)(resv + resv_len - (aligned + sz));
+    if (tail > 0)
+        munmap(aligned + sz, tail);
+    (void)madvise(p, sz, MADV_HUGEPAGE); // si el kernel no lo soporta se sigue con páginas normales
+    return p;
+}
+
+// Carga las tablas de páginas ahora para no pagar un fallo de página en el primer acceso
+static void prefault(void *p, size_t sz, bool writable) {
+#if defined(MADV_POPULATE_READ) && defined(MADV_POPULATE_WRITE)
+    if (madvise(p, sz, writable ? MADV_POPULATE_WRITE : MADV_POPULATE_READ) == 0)
+        return;
+#endif
+    long page = sysconf(_SC_PAGESIZE);
+    volatile char *c = p;
+    for (size_t off = 0; off < sz; off += (size_t)page) {
+        if (writable)
+            c[off] = c[off];
+        else
+            (void)c[off];
+    }
+}
+
+static void *map_with_opts(int fd, size_t sz, bool readonly, unsigned opts) {
+    int prot = readonly ? PROT_READ : PROT_READ | PROT_WRITE;
+    void *p;
+    if (opts & SHM_MAP_HUGEPAGES)
+        p = map_huge(fd, sz, prot);
+    else
+        p = readonly ? map_ro(fd, sz) : map_rw(fd, sz);
+    if (!p)
+        return NULL;
+    if ((opts & SHM_MAP_LOCK) && mlock(p, sz) == -1) {
+        int e = errno;
+        munmap(p, sz);
+        errno = e;
+        return NULL;
+    }
+    if ((opts & SHM_MAP_PREFAULT) && !(opts & SHM_MAP_LOCK)) // mlock ya carga todas las páginas
+        prefault(p, sz, !readonly);
+    return p;
+}
+
 static int unmap_if_mapped(struct shm_cdt *r) { 
     if (r->base && r->size) { 
         if (munmap(r->base, r->size) == -1)  
@@ -70,13 +130,22 @@ static int init_game_sync_semaphores(game_sync_t *sync){
         if (sem_init(&sync->player_ready[i], 1, 0) == -1) 
             return -1; // G[i]
     }
+    sync->ext_magic = GAME_SYNC_MAGIC;
+    sync->read_protocol = READ_PROTOCOL_RW;
+    sync->seq = 0; // H
+    sync->features = 0;
+    sync->state_map_opts = 0;
+    sync->board_format = BOARD_FORMAT_INT;
+    sync->move_transport = MOVE_TRANSPORT_PIPE;
+    sync->view_fps = 0;
+    sync->view_generation = 0;
     return 0;
 }
 
 
 
 
-static int shm_region_open_internal(shm_adt *out_handle, const char *name, size_t size_bytes, bool readonly) {
+static int shm_region_open_internal(shm_adt *out_handle, const char *name, size_t size_bytes, bool readonly, bool create) {
     if (!out_handle || !name || size_bytes == 0) { 
         errno = EINVAL; 
         return -1; 
@@ -93,7 +162,7 @@ static int shm_region_open_internal(shm_adt *out_handle, const char *name, size_
     }
 
     // Solo el proceso que va a escribir intenta crear con O_CREAT | O_EXCL
-    if (!readonly) {
+    if (!readonly && create) {
         h->fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
         
         if (h->fd != -1) { 
@@ -113,8 +182,8 @@ static int shm_region_open_internal(shm_adt *out_handle, const char *name, size_
             h->owner = false;
         }
     } else {
-        // Procesos readonly solo abren, no crean
-        h->fd = shm_open(name, O_RDONLY, 0);
+        // Procesos readonly (o que solo se suman a una región del master) abren, no crean
+        h->fd = shm_open(name, readonly ? O_RDONLY : O_RDWR, 0);
         h->owner = false;
     }
 
@@ -144,11 +213,20 @@ static int shm_region_open_internal(shm_adt *out_handle, const char *name, size_
 }
 
 int shm_region_open(shm_adt *out_handle, const char *name, size_t size_bytes) {
-    return shm_region_open_internal(out_handle, name, size_bytes, false);
+    return shm_region_open_internal(out_handle, name, size_bytes, false, true);
 }
 
 int shm_region_open_readonly(shm_adt *out_handle, const char *name, size_t size_bytes) {
-    return shm_region_open_internal(out_handle, name, size_bytes, true);
+    return shm_region_open_internal(out_handle, name, size_bytes, true, false);
+}
+
+int shm_region_open_existing(shm_adt *out_handle, const char *name) {
+    return shm_region_open_internal(out_handle, name, 1, false, false);
+}
+
+const char *shm_region_name(const char *env_var, const char *default_name) {
+    const char *name = getenv(env_var);
+    return (name && name[0] == '/') ? name : default_name;
 }
 
 int shm_region_close(shm_adt handle) {
@@ -170,14 +248,14 @@ int shm_region_close(shm_adt handle) {
 
 
 
-static int game_state_map_internal(shm_adt handle, unsigned short width, unsigned short height, game_state_t **out_state, bool readonly) {
+static int game_state_map_internal(shm_adt handle, unsigned short width, unsigned short height, board_format_t format, unsigned opts, game_state_t **out_state, bool readonly) {
     if (!handle || !out_state || width == 0 || height == 0) { 
         errno = EINVAL; 
         return -1; 
     }
     struct shm_cdt *h = (struct shm_cdt*)handle;
 
-    size_t need = game_state_size(width, height);
+    size_t need = game_state_size(width, height, format);
 
     if (h->owner && h->size < need) {
         if (ensure_size(h->fd, need) == -1) 
@@ -185,6 +263,15 @@ static int game_state_map_internal(shm_adt handle, unsigned short width, unsigne
         h->size = need;
     }
 
+    // Reserva las páginas de tmpfs de una vez en lugar de a medida que se tocan
+    if (h->owner && (opts & SHM_MAP_PREFAULT)) {
+        int e = posix_fallocate(h->fd, 0, (off_t)h->size);
+        if (e != 0) {
+            errno = e;
+            return -1;
+        }
+    }
+
     if (!h->base || h->size < need) {
         if (unmap_if_mapped(h) == -1) 
             return -1;
@@ -192,7 +279,7 @@ static int game_state_map_internal(shm_adt handle, unsigned short width, unsigne
             errno = EINVAL; 
             return -1; 
         } 
-        h->base = readonly ? map_ro(h->fd, h->size) : map_rw(h->fd, h->size);
+        h->base = map_with_opts(h->fd, h->size, readonly, opts);
         if (!h->base) 
             return -1;
     }
@@ -200,8 +287,10 @@ static int game_state_map_internal(shm_adt handle, unsigned short width, unsigne
     game_state_t *gs = (game_state_t*)h->base;
     *out_state = gs;
 
+    // La región recién creada (O_EXCL) ya viene en cero: solo se inicializa el encabezado,
+    // sin tocar cada página del tablero
     if (h->owner) {
-        memset(gs, 0, h->size);
+        memset(gs, 0, sizeof(*gs));
         gs->board_width   = width;
         gs->board_height  = height;
         gs->num_players   = 0;
@@ -210,12 +299,12 @@ static int game_state_map_internal(shm_adt handle, unsigned short width, unsigne
     return 0;
 }
 
-int game_state_map(shm_adt handle, unsigned short width, unsigned short height, game_state_t **out_state) {
-    return game_state_map_internal(handle, width, height, out_state, false);
+int game_state_map(shm_adt handle, unsigned short width, unsigned short height, board_format_t format, unsigned opts, game_state_t **out_state) {
+    return game_state_map_internal(handle, width, height, format, opts, out_state, false);
 }
 
-int game_state_map_readonly(shm_adt handle, unsigned short width, unsigned short height, game_state_t **out_state) {
-    return game_state_map_internal(handle, width, height, out_state, true);
+int game_state_map_readonly(shm_adt handle, unsigned short width, unsigned short height, board_format_t format, unsigned opts, game_state_t **out_state) {
+    return game_state_map_internal(handle, width, height, format, opts, out_state, true);
 }
 
 
@@ -234,10 +323,12 @@ int game_sync_map(shm_adt handle, game_sync_t **out_sync) {
         h->size = need;
     }
 
-    if (!h->base || h->size < need) {
+    // Una región ajena puede no tener las extensiones (master de la cátedra): alcanza con la parte común
+    size_t min_size = h->owner ? need : GAME_SYNC_LEGACY_SIZE;
+    if (!h->base || h->size < min_size) {
         if (unmap_if_mapped(h) == -1) 
             return -1;
-        if (!h->owner && h->size < need) { 
+        if (h->size < min_size) { 
             errno = EINVAL; 
             return -1; 
         }
@@ -252,12 +343,164 @@ int game_sync_map(shm_adt handle, game_sync_t **out_sync) {
     if (h->owner) {
         if (init_game_sync_semaphores(sync) == -1)
             return -1;
+        // Semáforos G de los jugadores que no entran en player_ready
+        sem_t *extra = (sem_t*)(sync + 1);
+        size_t extra_count = (h->size - sizeof(game_sync_t)) / sizeof(sem_t);
+        for (size_t i = 0; i < extra_count; i++) {
+            if (sem_init(&extra[i], 1, 0) == -1)
+                return -1;
+        }
     }
 
     return 0;
 }
 
 
+bool game_sync_has_ext(shm_adt handle) {
+    struct shm_cdt *h = (struct shm_cdt*)handle;
+    if (!h || !h->base || h->size < sizeof(game_sync_t))
+        return false;
+    return ((game_sync_t*)h->base)->ext_magic == GAME_SYNC_MAGIC;
+}
+
+read_protocol_t game_sync_read_protocol(shm_adt handle) {
+    if (!game_sync_has_ext(handle))
+        return READ_PROTOCOL_RW;
+    const game_sync_t *sync = (const game_sync_t*)((struct shm_cdt*)handle)->base;
+    return sync->read_protocol == READ_PROTOCOL_SEQLOCK ? READ_PROTOCOL_SEQLOCK : READ_PROTOCOL_RW;
+}
+
+unsigned game_sync_state_map_opts(shm_adt handle) {
+    if (!game_sync_has_ext(handle))
+        return 0;
+    return ((const game_sync_t*)((struct shm_cdt*)handle)->base)->state_map_opts;
+}
+
+board_format_t game_sync_board_format(shm_adt handle) {
+    if (!game_sync_has_ext(handle))
+        return BOARD_FORMAT_INT;
+    const game_sync_t *sync = (const game_sync_t*)((struct shm_cdt*)handle)->base;
+    return sync->board_format == BOARD_FORMAT_COMPACT ? BOARD_FORMAT_COMPACT : BOARD_FORMAT_INT;
+}
+
+move_transport_t game_sync_move_transport(shm_adt handle) {
+    if (!game_sync_has_ext(handle))
+        return MOVE_TRANSPORT_PIPE;
+    const game_sync_t *sync = (const game_sync_t*)((struct shm_cdt*)handle)->base;
+    return sync->move_transport == MOVE_TRANSPORT_RING ? MOVE_TRANSPORT_RING : MOVE_TRANSPORT_PIPE;
+}
+
+unsigned game_sync_view_fps(shm_adt handle) {
+    if (!game_sync_has_ext(handle))
+        return 0;
+    return ((const game_sync_t*)((struct shm_cdt*)handle)->base)->view_fps;
+}
+
+const delta_log_t *game_state_delta_log(shm_adt state_handle, shm_adt sync_handle, unsigned short width, unsigned short height) {
+    if (!game_sync_has_ext(sync_handle))
+        return NULL;
+    const game_sync_t *sync = (const game_sync_t*)((struct shm_cdt*)sync_handle)->base;
+    struct shm_cdt *h = (struct shm_cdt*)state_handle;
+    size_t off = delta_log_offset(width, height, game_sync_board_format(sync_handle));
+    if (!(sync->features & GAME_FEATURE_DELTA_LOG) || !h->base || h->size < off + sizeof(delta_log_t))
+        return NULL;
+    const delta_log_t *log = (const delta_log_t*)((const char*)h->base + off);
+    if (log->capacity == 0 || (log->capacity & (log->capacity - 1)) != 0 || h->size < off + delta_log_size(log->capacity))
+        return NULL;
+    return log;
+}
+
+const player_t *game_state_extra_players(shm_adt state_handle, shm_adt sync_handle, unsigned short width, unsigned short height) {
+    if (!game_sync_has_ext(sync_handle))
+        return NULL;
+    struct shm_cdt *h = (struct shm_cdt*)state_handle;
+    size_t off = extra_players_offset(width, height, game_sync_board_format(sync_handle));
+    if (!h->base || h->size <= off)
+        return NULL;
+    return (const player_t*)((const char*)h->base + off);
+}
+
+int move_rings_map(shm_adt handle, unsigned num_players, move_rings_t **out_rings) {
+    if (!handle || !out_rings) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct shm_cdt *h = (struct shm_cdt*)handle;
+    if (h->owner && h->size < move_rings_size(num_players)) {
+        if (ensure_size(h->fd, move_rings_size(num_players)) == -1)
+            return -1;
+        h->size = move_rings_size(num_players);
+    }
+    if (!h->base) {
+        if (h->size < move_rings_size(0)) {
+            errno = EINVAL;
+            return -1;
+        }
+        h->base = map_rw(h->fd, h->size);
+        if (!h->base)
+            return -1;
+    }
+    move_rings_t *r = (move_rings_t*)h->base;
+    if (h->owner)
+        r->num_rings = num_players; // la región recién creada ya está en cero
+    else if (h->size < move_rings_size(r->num_rings) || r->num_rings < num_players) {
+        errno = EINVAL;
+        return -1;
+    }
+    *out_rings = r;
+    return 0;
+}
+
+
+static int game_stats_map_internal(shm_adt handle, unsigned num_players, bool readonly, game_stats_t **out_stats) {
+    if (!handle || !out_stats) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct shm_cdt *h = (struct shm_cdt*)handle;
+    if (h->owner && h->size < game_stats_size(num_players)) {
+        if (ensure_size(h->fd, game_stats_size(num_players)) == -1)
+            return -1;
+        h->size = game_stats_size(num_players);
+    }
+    if (!h->base) {
+        if (h->size < game_stats_size(0)) {
+            errno = EINVAL;
+            return -1;
+        }
+        h->base = readonly ? map_ro(h->fd, h->size) : map_rw(h->fd, h->size);
+        if (!h->base)
+            return -1;
+    }
+    game_stats_t *st = (game_stats_t*)h->base;
+    if (h->owner) {
+        // La región recién creada ya está en cero
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        st->num_players = num_players;
+        st->start_ns = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+        __atomic_store_n(&st->magic, GAME_STATS_MAGIC, __ATOMIC_RELEASE);
+    } else if (__atomic_load_n(&st->magic, __ATOMIC_ACQUIRE) != GAME_STATS_MAGIC ||
+               h->size < game_stats_size(st->num_players) || st->num_players < num_players) {
+        errno = EINVAL;
+        return -1;
+    }
+    *out_stats = st;
+    return 0;
+}
+
+int game_stats_map(shm_adt handle, unsigned num_players, game_stats_t **out_stats) {
+    return game_stats_map_internal(handle, num_players, false, out_stats);
+}
+
+int game_stats_map_readonly(shm_adt handle, const game_stats_t **out_stats) {
+    game_stats_t *st;
+    if (game_stats_map_internal(handle, 0, true, &st) == -1)
+        return -1;
+    *out_stats = st;
+    return 0;
+}
+
 int game_state_unmap_destroy(shm_adt handle) {
     if (!handle) { 
         errno = EINVAL; 
@@ -277,6 +520,15 @@ int game_state_unmap_destroy(shm_adt handle) {
 }
 
 
+// Las regiones de movimientos y de contadores no tienen nada que destruir además del mapeo
+int move_rings_unmap_destroy(shm_adt handle) {
+    return game_state_unmap_destroy(handle);
+}
+
+int game_stats_unmap_destroy(shm_adt handle) {
+    return game_state_unmap_destroy(handle);
+}
+
 int game_sync_unmap_destroy(shm_adt handle) {
     if (!handle) { 
         errno = EINVAL; 
@@ -295,6 +547,10 @@ int game_sync_unmap_destroy(shm_adt handle) {
         e |= sem_destroy(&sync->reader_count_mutex);
         for (int i = 0; i < MAX_PLAYERS; ++i) 
             e |= sem_destroy(&sync->player_ready[i]);
+        sem_t *extra = (sem_t*)(sync + 1);
+        size_t extra_count = (h->size - sizeof(game_sync_t)) / sizeof(sem_t);
+        for (size_t i = 0; i < extra_count; ++i)
+            e |= sem_destroy(&extra[i]);
         if (e == -1) 
             result = -1;
     }
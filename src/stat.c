@@ -0,0 +1,163 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+// Monitor de la región de estadísticas: la mapea de solo lectura y cada intervalo imprime
+// las tasas desde la muestra anterior, sin tocar ningún lock del juego
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "shm.h"
+#include "stats.h"
+
+#define DEFAULT_INTERVAL_MS 1000
+
+typedef struct {
+    double t;                          // segundos desde que se creó la región
+    uint64_t moves, valid, locks, lock_wait_ns, wakeups, notifies, frames, skipped;
+    uint64_t bytes, reads, eagain, turns, retries, think_ns;
+} sample_t;
+
+static void usage(const char *prog) {
+    fprintf(stderr, "uso: %s [-i interval_ms] [-s shm_name] [-p]\n", prog);
+    exit(ERROR_INVALID_ARGS);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void take_sample(const game_stats_t *st, sample_t *s) {
+    memset(s, 0, sizeof(*s));
+    s->t = now_s() - (double)st->start_ns / 1e9;
+    s->moves = stats_load(&st->moves_applied);
+    s->valid = stats_load(&st->moves_valid);
+    s->locks = stats_load(&st->lock_acquisitions);
+    s->lock_wait_ns = stats_load(&st->lock_wait_ns);
+    s->wakeups = stats_load(&st->wakeups);
+    s->notifies = stats_load(&st->view_notifies);
+    s->frames = stats_load(&st->view_frames);
+    s->skipped = stats_load(&st->view_skipped);
+    for (unsigned i = 0; i < st->num_players; i++) {
+        const game_stats_player_t *p = &st->players[i];
+        s->bytes += stats_load(&p->bytes_read);
+        s->reads += stats_load(&p->reads);
+        s->eagain += stats_load(&p->eagain);
+        s->turns += stats_load(&p->turns);
+        s->retries += stats_load(&p->snapshot_retries);
+        s->think_ns += stats_load(&p->think_ns);
+    }
+}
+
+static double per_s(uint64_t cur, uint64_t prev, double dt) {
+    return dt > 0 ? (double)(cur - prev) / dt : 0.0;
+}
+
+static double avg(uint64_t sum, uint64_t prev_sum, uint64_t n, uint64_t prev_n) {
+    return n > prev_n ? (double)(sum - prev_sum) / (double)(n - prev_n) : 0.0;
+}
+
+static void print_header(void) {
+    printf("%8s %10s %10s %10s %12s %10s %9s %9s %11s %10s %10s %12s\n", "time_s", "moves/s", "valid/s", "locks/s",
+           "lock_wait_ns", "wakeups/s", "frames/s", "skipped/s", "bytes/s", "eagain/s", "retries/s", "think_ns");
+}
+
+static void print_rates(const sample_t *cur, const sample_t *prev) {
+    double dt = cur->t - prev->t;
+    printf("%8.1f %10.0f %10.0f %10.0f %12.0f %10.0f %9.0f %9.0f %11.0f %10.0f %10.0f %12.0f\n", cur->t,
+           per_s(cur->moves, prev->moves, dt), per_s(cur->valid, prev->valid, dt), per_s(cur->locks, prev->locks, dt),
+           avg(cur->lock_wait_ns, prev->lock_wait_ns, cur->locks, prev->locks),
+           per_s(cur->wakeups, prev->wakeups, dt), per_s(cur->frames, prev->frames, dt),
+           per_s(cur->skipped, prev->skipped, dt), per_s(cur->bytes, prev->bytes, dt),
+           per_s(cur->eagain, prev->eagain, dt), per_s(cur->retries, prev->retries, dt),
+           avg(cur->think_ns, prev->think_ns, cur->turns, prev->turns));
+}
+
+// Totales por jugador desde el inicio de la partida
+static void print_players(const game_stats_t *st) {
+    printf("%8s %12s %10s %10s %10s %10s %12s\n", "player", "bytes", "reads", "eagain", "turns", "retries", "think_ns");
+    for (unsigned i = 0; i < st->num_players; i++) {
+        const game_stats_player_t *p = &st->players[i];
+        uint64_t turns = stats_load(&p->turns);
+        printf("%8u %12llu %10llu %10llu %10llu %10llu %12.0f\n", i, (unsigned long long)stats_load(&p->bytes_read),
+               (unsigned long long)stats_load(&p->reads), (unsigned long long)stats_load(&p->eagain),
+               (unsigned long long)turns, (unsigned long long)stats_load(&p->snapshot_retries),
+               turns ? (double)stats_load(&p->think_ns) / (double)turns : 0.0);
+    }
+}
+
+int main(int argc, char **argv) {
+    long interval_ms = DEFAULT_INTERVAL_MS;
+    const char *name = shm_region_name(ENV_SHM_STATS, SHM_STATS);
+    bool per_player = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:s:p")) != -1) {
+        switch (opt) {
+        case 'i':
+            interval_ms = atol(optarg);
+            if (interval_ms <= 0)
+                usage(argv[0]);
+            break;
+        case 's':
+            name = optarg;
+            break;
+        case 'p':
+            per_player = true;
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    // Se puede lanzar antes que el master: se espera a que la región exista y esté inicializada
+    shm_adt h;
+    const game_stats_t *st;
+    struct timespec ts = { .tv_sec = interval_ms / 1000, .tv_nsec = (interval_ms % 1000) * 1000000L };
+    bool waiting = false;
+    while (1) {
+        if (shm_region_open_readonly(&h, name, game_stats_size(0)) == 0) {
+            if (game_stats_map_readonly(h, &st) == 0)
+                break;
+            int e = errno;
+            shm_region_close(h);
+            errno = e;
+        }
+        if (errno != ENOENT && errno != EINVAL) {
+            perror("stat: attach stats region");
+            return ERROR_SHM_ATTACH;
+        }
+        if (!waiting) {
+            fprintf(stderr, "stat: waiting for %s\n", name);
+            waiting = true;
+        }
+        nanosleep(&ts, NULL);
+    }
+
+    printf("%s: %u players\n", name, st->num_players);
+    print_header();
+    sample_t prev, cur;
+    take_sample(st, &prev);
+    bool finished = false;
+    while (!finished) {
+        nanosleep(&ts, NULL);
+        // finished se lee antes de la muestra: la última línea ya incluye todo lo de la partida
+        finished = __atomic_load_n(&st->finished, __ATOMIC_RELAXED) != 0;
+        take_sample(st, &cur);
+        print_rates(&cur, &prev);
+        if (per_player)
+            print_players(st);
+        fflush(stdout);
+        prev = cur;
+    }
+    printf("finished: %llu moves (%llu valid), %llu view frames\n", (unsigned long long)cur.moves,
+           (unsigned long long)cur.valid, (unsigned long long)cur.frames);
+    shm_region_close(h);
+    return SUCCESS;
+}
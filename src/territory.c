@@ -0,0 +1,219 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "territory.h"
+
+// Estado por jugador durante una evaluación, al final del bloque de memoria de territory_t
+typedef struct {
+    int lo, hi;             // filas con frontera
+    unsigned char par;      // cuál de sus dos buffers es la frontera actual
+    bool active;
+} source_state_t;
+
+// Cada fila lleva una palabra más en cero y hay una fila en cero arriba y otra abajo: los shifts
+// entre palabras y las filas vecinas se leen sin preguntar por los bordes
+static size_t row_stride(const territory_t *t) {
+    return (size_t)t->words + 1;
+}
+
+static size_t plane_words(const territory_t *t) {
+    return (size_t)(t->height + 2) * row_stride(t);
+}
+
+static size_t row_offset(const territory_t *t, int y) {
+    return (size_t)(y + 1) * row_stride(t);
+}
+
+static source_state_t *source_states(territory_t *t) {
+    return (source_state_t *)(t->next + plane_words(t));
+}
+
+// Frontera del jugador i (par elige cuál de sus dos buffers) y celdas que ya son suyas
+static uint64_t *front_plane(territory_t *t, unsigned i, unsigned par) {
+    return t->front + (size_t)(3 * i + par) * plane_words(t);
+}
+
+static uint64_t *owned_plane(territory_t *t, unsigned i) {
+    return t->front + (size_t)(3 * i + 2) * plane_words(t);
+}
+
+int territory_init(territory_t *t, int width, int height, unsigned max_sources) {
+    memset(t, 0, sizeof(*t));
+    t->width = width;
+    t->height = height;
+    t->words = (width + 63) / 64;
+    t->max_sources = max_sources;
+    size_t plane = plane_words(t);
+    // free_mask, planos, avail, once, twice, dos fronteras y lo propio por jugador, next (filas dilatadas)
+    size_t planes = 1 + TERRITORY_PLANES + 3 + 3 * (size_t)max_sources + 1;
+    uint64_t *mem = calloc(1, planes * plane * sizeof(uint64_t) + max_sources * sizeof(source_state_t));
+    if (!mem)
+        return -1;
+    t->free_mask = mem;
+    for (int k = 0; k < TERRITORY_PLANES; k++)
+        t->planes[k] = mem + (size_t)(1 + k) * plane;
+    t->avail = mem + (size_t)(1 + TERRITORY_PLANES) * plane;
+    t->once = t->avail + plane;
+    t->twice = t->once + plane;
+    t->front = t->twice + plane;
+    t->next = t->front + 3 * (size_t)max_sources * plane;
+    return 0;
+}
+
+void territory_free(territory_t *t) {
+    free(t->free_mask);
+    t->free_mask = NULL;
+}
+
+void territory_set_cell(territory_t *t, int x, int y, int value) {
+    size_t w = row_offset(t, y) + (size_t)(x >> 6);
+    uint64_t bit = 1ull << (x & 63);
+    if (cell_is_free(value)) {
+        t->free_mask[w] |= bit;
+        for (int k = 0; k < TERRITORY_PLANES; k++) {
+            if (value & (1 << k))
+                t->planes[k][w] |= bit;
+            else
+                t->planes[k][w] &= ~bit;
+        }
+    } else {
+        t->free_mask[w] &= ~bit;
+        for (int k = 0; k < TERRITORY_PLANES; k++)
+            t->planes[k][w] &= ~bit;
+    }
+}
+
+void territory_set_board(territory_t *t, const int board[]) {
+    size_t plane = plane_words(t);
+    memset(t->free_mask, 0, plane * sizeof(uint64_t));
+    for (int k = 0; k < TERRITORY_PLANES; k++)
+        memset(t->planes[k], 0, plane * sizeof(uint64_t));
+    for (int y = 0; y < t->height; y++)
+        for (int x = 0; x < t->width; x++)
+            if (cell_is_free(board[idx(x, y, t->width)]))
+                territory_set_cell(t, x, y, board[idx(x, y, t->width)]);
+}
+
+void territory_eval(territory_t *t, const territory_source_t *sources, unsigned n, unsigned *reward, unsigned *cells) {
+    int H = t->height;
+    size_t stride = row_stride(t);
+    source_state_t *st = source_states(t);
+    if (n > t->max_sources)
+        n = t->max_sources;
+    unsigned active = 0;
+    for (unsigned i = 0; i < n; i++) {
+        reward[i] = 0;
+        if (cells)
+            cells[i] = 0;
+        st[i].active = sources[i].x >= 0 && is_inside(sources[i].x, sources[i].y, t->width, H);
+        if (!st[i].active)
+            continue;
+        st[i].lo = st[i].hi = sources[i].y;
+        st[i].par = 0;
+        memset(owned_plane(t, i), 0, plane_words(t) * sizeof(uint64_t));
+        uint64_t *row = front_plane(t, i, 0) + row_offset(t, sources[i].y);
+        memset(row, 0, stride * sizeof(uint64_t));
+        row[sources[i].x >> 6] = 1ull << (sources[i].x & 63);
+        active++;
+    }
+    memcpy(t->avail, t->free_mask, plane_words(t) * sizeof(uint64_t));
+
+    uint64_t *h = t->next;
+    while (active) {
+        int ulo = H, uhi = -1;
+        for (unsigned i = 0; i < n; i++) {
+            if (!st[i].active)
+                continue;
+            int lo = st[i].lo > 0 ? st[i].lo - 1 : 0;
+            int hi = st[i].hi < H - 1 ? st[i].hi + 1 : H - 1;
+            ulo = lo < ulo ? lo : ulo;
+            uhi = hi > uhi ? hi : uhi;
+        }
+        size_t ubeg = row_offset(t, ulo), uend = row_offset(t, uhi + 1);
+        memset(t->once + ubeg, 0, (uend - ubeg) * sizeof(uint64_t));
+        memset(t->twice + ubeg, 0, (uend - ubeg) * sizeof(uint64_t));
+
+        // Expansión de cada frontera sobre las celdas que nadie alcanzó todavía: primero los
+        // vecinos horizontales de cada fila (en h), después la unión con las filas de arriba y abajo
+        for (unsigned i = 0; i < n; i++) {
+            if (!st[i].active)
+                continue;
+            const uint64_t *cur = front_plane(t, i, st[i].par);
+            uint64_t *out = front_plane(t, i, st[i].par ^ 1);
+            size_t beg = row_offset(t, st[i].lo), end = row_offset(t, st[i].hi + 1);
+            // Las dos filas de cada lado se leen al unir con las vecinas: van en cero
+            size_t zbeg = row_offset(t, st[i].lo > 0 ? st[i].lo - 2 : -1);
+            size_t zend = row_offset(t, st[i].hi < H - 1 ? st[i].hi + 3 : H + 1);
+            memset(h + zbeg, 0, (beg - zbeg) * sizeof(uint64_t));
+            memset(h + end, 0, (zend - end) * sizeof(uint64_t));
+            for (size_t k = beg; k < end; k++) {
+                uint64_t v = cur[k];
+                h[k] = v | (v << 1) | (cur[k - 1] >> 63) | (v >> 1) | (cur[k + 1] << 63);
+            }
+            size_t nbeg = row_offset(t, st[i].lo > 0 ? st[i].lo - 1 : 0);
+            size_t nend = row_offset(t, st[i].hi < H - 1 ? st[i].hi + 2 : H);
+            for (size_t k = nbeg; k < nend; k++) {
+                uint64_t v = (h[k - stride] | h[k] | h[k + stride]) & t->avail[k];
+                out[k] = v;
+                t->twice[k] |= t->once[k] & v;
+                t->once[k] |= v;
+            }
+        }
+
+        // Lo alcanzado por un solo jugador es suyo. Lo disputado no es de nadie, pero la frontera
+        // sigue por ahí: así cada uno llega a cada celda por su camino más corto
+        for (unsigned i = 0; i < n; i++) {
+            if (!st[i].active)
+                continue;
+            st[i].par ^= 1;
+            const uint64_t *row = front_plane(t, i, st[i].par);
+            uint64_t *owned = owned_plane(t, i);
+            int nlo = st[i].lo > 0 ? st[i].lo - 1 : 0, nhi = st[i].hi < H - 1 ? st[i].hi + 1 : H - 1;
+            int lo = H, hi = -1;
+            for (int y = nlo; y <= nhi; y++) {
+                size_t beg = row_offset(t, y), end = beg + (size_t)t->words;
+                uint64_t any = 0;
+                for (size_t k = beg; k < end; k++) {
+                    any |= row[k];
+                    owned[k] |= row[k] & ~t->twice[k];
+                }
+                if (any) {
+                    lo = y < lo ? y : lo;
+                    hi = y;
+                }
+            }
+            if (hi < 0) {
+                st[i].active = false;
+                active--;
+            } else {
+                st[i].lo = lo;
+                st[i].hi = hi;
+            }
+        }
+        for (size_t k = ubeg; k < uend; k++)
+            t->avail[k] &= ~t->once[k];
+    }
+
+    // La recompensa sale de los planos de bits: popcount de lo propio en cada uno
+    for (unsigned i = 0; i < n; i++) {
+        if (sources[i].x < 0 || !is_inside(sources[i].x, sources[i].y, t->width, H))
+            continue;
+        const uint64_t *owned = owned_plane(t, i);
+        unsigned r = 0, c = 0;
+        for (size_t k = stride; k < plane_words(t) - stride; k++) {
+            uint64_t v = owned[k];
+            if (!v)
+                continue;
+            for (int b = 0; b < TERRITORY_PLANES; b++)
+                r += (unsigned)__builtin_popcountll(v & t->planes[b][k]) << b;
+            c += (unsigned)__builtin_popcountll(v);
+        }
+        reward[i] = r;
+        if (cells)
+            cells[i] = c;
+    }
+}
@@ -0,0 +1,286 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+// Corre muchas partidas con semillas consecutivas repartidas entre varios procesos
+
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "common.h"
+#include "match.h"
+
+#define DEFAULT_TOURNAMENT_TIMEOUT_S 2
+#define RESULT_LINE_LEN (MAX_NAME_LEN + 96)
+
+typedef struct {
+    game_args_t game;      // configuración común a todas las partidas
+    unsigned first_seed;
+    unsigned last_seed;
+    int workers;
+    const char *out_path;
+    const char *record_dir; // si no es NULL, cada partida se graba en <record_dir>/<seed>.rec
+    bool keep_players;      // cada worker reusa sus jugadores entre partidas (player_pool_t)
+} tournament_args_t;
+
+// Contador compartido entre los workers: cada uno toma la próxima semilla libre
+typedef struct {
+    unsigned long next;
+    unsigned long games;
+    unsigned long failed;
+    unsigned long forfeits; // turnos perdidos por plazo en todas las partidas
+} tournament_progress_t;
+
+
+static void die(const char *m, int error_code) {
+    puts(m);
+    exit(error_code);
+}
+
+static void usage(void) {
+    die("Usage: ./tournament [-w width] [-h height] [-t timeout] [-T turn_ms] [-j workers] [-o results.csv] [-l rw|seqlock] [-m huge,prefault,lock] [-c] [-e] [-k] [-g rand|counter] [-x pipe|ring] [-r record_dir] -s first:last -p player1 player2...", ERROR_INVALID_ARGS);
+}
+
+static void parse_seed_range(const char *arg, unsigned *first, unsigned *last) {
+    char *end;
+    *first = (unsigned)strtoul(arg, &end, 10);
+    *last = *first;
+    if (*end == ':')
+        *last = (unsigned)strtoul(end + 1, &end, 10);
+    if (*end != '\0' || *last < *first)
+        usage();
+}
+
+static tournament_args_t parse_args(int argc, char **argv) {
+    tournament_args_t args;
+    memset(&args, 0, sizeof args);
+    args.game.board_width = MIN_BOARD_SIZE;
+    args.game.board_height = MIN_BOARD_SIZE;
+    args.game.delay_ms = 0;
+    args.game.timeout_s = DEFAULT_TOURNAMENT_TIMEOUT_S;
+    args.game.view_bin = NULL;
+    args.game.read_protocol = READ_PROTOCOL_SEQLOCK;
+    args.game.board_format = BOARD_FORMAT_INT;
+    args.game.board_gen = BOARD_GEN_COUNTER;
+    args.game.batch_moves = true; // sin vista ni delay no cambia nada más que la cantidad de locks
+    args.workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    args.out_path = "results.csv";
+    bool has_seeds = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-w") && argc > i + 1)
+            args.game.board_width = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-h") && argc > i + 1)
+            args.game.board_height = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && argc > i + 1)
+            args.game.timeout_s = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-T") && argc > i + 1)
+            args.game.turn_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-j") && argc > i + 1)
+            args.workers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && argc > i + 1)
+            args.out_path = argv[++i];
+        else if (!strcmp(argv[i], "-r") && argc > i + 1)
+            args.record_dir = argv[++i];
+        else if (!strcmp(argv[i], "-l") && argc > i + 1) {
+            int protocol = parse_read_protocol(argv[++i]);
+            if (protocol < 0)
+                usage();
+            args.game.read_protocol = (read_protocol_t)protocol;
+        }
+        else if (!strcmp(argv[i], "-c"))
+            args.game.board_format = BOARD_FORMAT_COMPACT;
+        else if (!strcmp(argv[i], "-e"))
+            args.game.early_finish = true;
+        else if (!strcmp(argv[i], "-k"))
+            args.keep_players = true;
+        else if (!strcmp(argv[i], "-g") && argc > i + 1) {
+            int gen = parse_board_gen(argv[++i]);
+            if (gen < 0)
+                usage();
+            args.game.board_gen = (board_gen_t)gen;
+        }
+        else if (!strcmp(argv[i], "-x") && argc > i + 1) {
+            int transport = parse_move_transport(argv[++i]);
+            if (transport < 0)
+                usage();
+            args.game.move_transport = (move_transport_t)transport;
+        }
+        else if (!strcmp(argv[i], "-m") && argc > i + 1) {
+            int opts = parse_map_opts(argv[++i]);
+            if (opts < 0)
+                usage();
+            args.game.state_map_opts = (unsigned)opts;
+        }
+        else if (!strcmp(argv[i], "-s") && argc > i + 1) {
+            parse_seed_range(argv[++i], &args.first_seed, &args.last_seed);
+            has_seeds = true;
+        }
+        else if (!strcmp(argv[i], "-p")) {
+            args.game.player_bins = &argv[i + 1];
+            args.game.num_players = 0;
+            while (argc > i + 1 && args.game.num_players < MAX_PLAYERS_EXT && argv[i + 1][0] != '-') {
+                args.game.num_players++;
+                i++;
+            }
+        }
+        else {
+            usage();
+        }
+    }
+
+    if (!has_seeds || args.game.num_players < 1)
+        usage();
+    if (args.game.board_width < MIN_BOARD_SIZE || args.game.board_width > MAX_BOARD_SIZE ||
+        args.game.board_height < MIN_BOARD_SIZE || args.game.board_height > MAX_BOARD_SIZE) {
+        printf("width and height must be between %d and %d\n", MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+        die("Invalid board size", ERROR_INVALID_ARGS);
+    }
+    if (args.game.num_players > MAX_PLAYERS && (long)args.game.num_players * 4 > (long)args.game.board_width * args.game.board_height)
+        die("Board too small for that many players", ERROR_INVALID_ARGS);
+    if (args.game.board_format == BOARD_FORMAT_COMPACT && args.game.num_players > MAX_COMPACT_PLAYERS)
+        die("The compact board format supports up to 129 players", ERROR_INVALID_ARGS);
+    int loaded = plugins_load(args.game.player_bins, (unsigned)args.game.num_players, &args.game.plugins);
+    if (loaded < 0)
+        die("Could not load the player plugins", ERROR_INVALID_ARGS);
+    if (loaded && args.game.board_format == BOARD_FORMAT_COMPACT)
+        die("Plugins play on the int board format", ERROR_INVALID_ARGS);
+    if (args.game.timeout_s < 1)
+        args.game.timeout_s = 1;
+    if (args.game.turn_ms < 0)
+        args.game.turn_ms = 0;
+    if (args.workers < 1)
+        args.workers = 1;
+    unsigned long total = (unsigned long)args.last_seed - args.first_seed + 1;
+    if ((unsigned long)args.workers > total)
+        args.workers = (int)total;
+    return args;
+}
+
+// Una línea CSV por jugador; toda la partida va en un único write para que no se mezcle con otros workers
+static void write_results(int fd, unsigned seed, const game_result_t *r) {
+    size_t cap = r->num_players * RESULT_LINE_LEN;
+    char *buf = malloc(cap);
+    if (!buf) {
+        perror("tournament: write results");
+        return;
+    }
+    size_t len = 0;
+    for (unsigned i = 0; i < r->num_players; i++) {
+        const player_t *p = &r->players[i];
+        len += (size_t)snprintf(buf + len, cap - len, "%u,%u,%s,%u,%u,%u,%d,%ld\n",
+                                seed, i, p->name, p->score, p->valid_moves, p->invalid_moves,
+                                r->exit_codes[i], r->duration_us);
+    }
+    if (write(fd, buf, len) != (ssize_t)len)
+        perror("tournament: write results");
+    free(buf);
+}
+
+static int run_worker(const tournament_args_t *args, int worker_id, int out_fd, tournament_progress_t *progress) {
+    char state_name[64], sync_name[64], moves_name[64], stats_name[64];
+    snprintf(state_name, sizeof state_name, "/chomp_%d_%d_state", (int)getppid(), worker_id);
+    snprintf(sync_name, sizeof sync_name, "/chomp_%d_%d_sync", (int)getppid(), worker_id);
+    snprintf(moves_name, sizeof moves_name, "/chomp_%d_%d_moves", (int)getppid(), worker_id);
+    snprintf(stats_name, sizeof stats_name, "/chomp_%d_%d_stats", (int)getppid(), worker_id);
+
+    game_args_t game = args->game;
+    game.shm_state = state_name;
+    game.shm_sync = sync_name;
+    game.shm_moves = moves_name;
+    game.shm_stats = stats_name;
+    char record_path[PATH_MAX];
+    // Sin pool la partida lanza sus propios jugadores: se juega igual, solo que más lento
+    if (args->keep_players && !game.plugins && !(game.pool = player_pool_create(game.player_bins, (unsigned)game.num_players)))
+        perror("tournament: could not create player pool");
+
+    unsigned long total = (unsigned long)args->last_seed - args->first_seed + 1;
+    while (1) {
+        unsigned long k = __atomic_fetch_add(&progress->next, 1, __ATOMIC_RELAXED);
+        if (k >= total)
+            break;
+        game.seed = args->first_seed + (unsigned)k;
+        if (args->record_dir) {
+            snprintf(record_path, sizeof record_path, "%s/%u.rec", args->record_dir, game.seed);
+            game.record_path = record_path;
+        }
+
+        game_result_t result;
+        if (run_game(&game, &result) != SUCCESS) {
+            game_result_free(&result);
+            __atomic_fetch_add(&progress->failed, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        write_results(out_fd, game.seed, &result);
+        __atomic_fetch_add(&progress->forfeits, result.turns_forfeited, __ATOMIC_RELAXED);
+        game_result_free(&result);
+        __atomic_fetch_add(&progress->games, 1, __ATOMIC_RELAXED);
+    }
+    player_pool_destroy(game.pool);
+    return SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    tournament_args_t args = parse_args(argc, argv);
+
+    int out_fd = open(args.out_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (out_fd == -1) {
+        perror("tournament: open results file");
+        return ERROR_INVALID_ARGS;
+    }
+    const char *header = "seed,player,name,score,valid_moves,invalid_moves,exit_code,duration_us\n";
+    if (write(out_fd, header, strlen(header)) < 0) {
+        perror("tournament: write results");
+        return ERROR_INVALID_ARGS;
+    }
+
+    tournament_progress_t *progress = mmap(NULL, sizeof *progress, PROT_READ | PROT_WRITE,
+                                           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (progress == MAP_FAILED) {
+        perror("tournament: mmap");
+        return ERROR_SHM;
+    }
+    memset(progress, 0, sizeof *progress);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int started = 0;
+    for (int w = 0; w < args.workers; w++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("tournament: fork");
+            break;
+        }
+        if (pid == 0)
+            _exit(run_worker(&args, w, out_fd, progress));
+        started++;
+    }
+    for (int w = 0; w < started; w++)
+        wait(NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double secs = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("games: %lu  failed: %lu  workers: %d  time: %.3f s  games/sec: %.1f\n",
+           progress->games, progress->failed, started, secs,
+           secs > 0 ? (double)progress->games / secs : 0.0);
+    if (args.game.turn_ms > 0)
+        printf("turns forfeited: %lu (deadline %d ms)\n", progress->forfeits, args.game.turn_ms);
+    printf("results: %s\n", args.out_path);
+    if (args.record_dir)
+        printf("recordings: %s\n", args.record_dir);
+
+    close(out_fd);
+    munmap(progress, sizeof *progress);
+    plugins_unload(args.game.plugins, (unsigned)args.game.num_players);
+    return started > 0 ? SUCCESS : ERROR_FORK;
+}
@@ -0,0 +1,252 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+// Reproduce muchas grabaciones en paralelo (threads, sin procesos) y verifica sus puntajes
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "common.h"
+#include "game.h"
+#include "record.h"
+
+#define RECORD_SUFFIX ".rec"
+
+typedef enum {
+    VERIFY_OK,
+    VERIFY_MISMATCH,      // algún puntaje o contador difiere del grabado
+    VERIFY_INCOMPLETE,    // la grabación no tiene resultados (master cortado)
+    VERIFY_CORRUPT,
+    VERIFY_UNREADABLE,
+} verify_status_t;
+
+static const char *status_names[] = { "ok", "MISMATCH", "INCOMPLETE", "CORRUPT", "UNREADABLE" };
+
+typedef struct {
+    char *path;
+    verify_status_t status;
+    unsigned long events;
+    unsigned bad_player;  // primer jugador que difiere (VERIFY_MISMATCH)
+} verify_job_t;
+
+typedef struct {
+    verify_job_t *jobs;
+    size_t count, cap;
+    size_t next;          // próximo trabajo libre; lo toman los threads con un fetch_add
+    int threads;
+    bool quiet;
+} verify_t;
+
+static void die(const char *m, int error_code) {
+    puts(m);
+    exit(error_code);
+}
+
+static void usage(void) {
+    die("Usage: ./verify [-j threads] [-q] record|dir [...]", ERROR_INVALID_ARGS);
+}
+
+static void add_job(verify_t *v, char *path) {
+    if (v->count == v->cap) {
+        v->cap = v->cap ? 2 * v->cap : 64;
+        v->jobs = realloc(v->jobs, v->cap * sizeof(*v->jobs));
+        if (!v->jobs)
+            die("verify: out of memory", ERROR_INVALID_ARGS);
+    }
+    memset(&v->jobs[v->count], 0, sizeof(v->jobs[0]));
+    v->jobs[v->count++].path = path;
+}
+
+static int cmp_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Un directorio aporta sus archivos .rec en orden alfabético, así la salida no depende del sistema de archivos
+static void add_dir(verify_t *v, const char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        perror(dir);
+        return;
+    }
+    char **names = NULL;
+    size_t n = 0, cap = 0;
+    struct dirent *e;
+    size_t suffix = strlen(RECORD_SUFFIX);
+    while ((e = readdir(d))) {
+        size_t len = strlen(e->d_name);
+        if (len <= suffix || strcmp(e->d_name + len - suffix, RECORD_SUFFIX) != 0)
+            continue;
+        if (n == cap) {
+            cap = cap ? 2 * cap : 64;
+            names = realloc(names, cap * sizeof(*names));
+            if (!names)
+                die("verify: out of memory", ERROR_INVALID_ARGS);
+        }
+        size_t plen = strlen(dir) + 1 + len + 1;
+        names[n] = malloc(plen);
+        if (!names[n])
+            die("verify: out of memory", ERROR_INVALID_ARGS);
+        snprintf(names[n++], plen, "%s/%s", dir, e->d_name);
+    }
+    closedir(d);
+    qsort(names, n, sizeof(*names), cmp_names);
+    for (size_t i = 0; i < n; i++)
+        add_job(v, names[i]);
+    free(names);
+}
+
+static void parse_args(int argc, char **argv, verify_t *v) {
+    memset(v, 0, sizeof(*v));
+    v->threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-j") && argc > i + 1) {
+            v->threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-q")) {
+            v->quiet = true;
+        } else if (argv[i][0] == '-') {
+            usage();
+        } else {
+            struct stat st;
+            if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode))
+                add_dir(v, argv[i]);
+            else
+                add_job(v, strdup(argv[i]));
+        }
+    }
+    if (v->count == 0)
+        usage();
+    if (v->threads < 1)
+        v->threads = 1;
+    if ((size_t)v->threads > v->count)
+        v->threads = (int)v->count;
+}
+
+static void compare_results(record_reader_t *rd, const game_t *g, verify_job_t *job) {
+    unsigned n = rd->header.num_players;
+    player_t *expected = calloc(n, sizeof(player_t));
+    if (!expected) {
+        job->status = VERIFY_UNREADABLE;
+        return;
+    }
+    if (record_reader_results(rd, expected, n) == -1) {
+        job->status = VERIFY_INCOMPLETE;
+    } else {
+        job->status = VERIFY_OK;
+        for (unsigned i = 0; i < n; i++) {
+            const player_t *p = game_player_ro(g->state, g->extra_players, i);
+            if (p->score != expected[i].score || p->valid_moves != expected[i].valid_moves ||
+                p->invalid_moves != expected[i].invalid_moves) {
+                job->status = VERIFY_MISMATCH;
+                job->bad_player = i;
+                break;
+            }
+        }
+    }
+    free(expected);
+}
+
+// Misma reconstrucción que replay, en memoria privada del thread
+static void verify_one(verify_job_t *job) {
+    record_reader_t rd;
+    if (record_reader_open(&rd, job->path) == -1) {
+        job->status = VERIFY_UNREADABLE;
+        return;
+    }
+    const record_header_t *h = &rd.header;
+    if ((h->board_gen != RECORD_BOARD_GEN_RAND && h->board_gen != RECORD_BOARD_GEN_COUNTER) || h->width < 1 || h->height < 1) {
+        job->status = VERIFY_CORRUPT;
+        record_reader_close(&rd);
+        return;
+    }
+    game_t g = { .format = (board_format_t)h->board_format };
+    g.state = calloc(1, game_state_size(h->width, h->height, g.format));
+    if (h->num_players > MAX_PLAYERS)
+        g.extra_players = calloc(extra_player_count(h->num_players), sizeof(player_t));
+    if (!g.state || (h->num_players > MAX_PLAYERS && !g.extra_players)) {
+        job->status = VERIFY_UNREADABLE;
+    } else if (record_game_setup(&rd, &g) == -1) {
+        job->status = VERIFY_CORRUPT;
+    } else {
+        record_event_t ev;
+        int st;
+        while ((st = record_reader_next(&rd, &ev)) == 1) {
+            record_apply(&g, &ev);
+            job->events++;
+        }
+        if (st == -1)
+            job->status = VERIFY_CORRUPT;
+        else
+            compare_results(&rd, &g, job);
+    }
+    free(g.state);
+    free(g.extra_players);
+    record_reader_close(&rd);
+}
+
+static void *verify_worker(void *arg) {
+    verify_t *v = arg;
+    while (1) {
+        size_t k = __atomic_fetch_add(&v->next, 1, __ATOMIC_RELAXED);
+        if (k >= v->count)
+            break;
+        verify_one(&v->jobs[k]);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    verify_t v;
+    parse_args(argc, argv, &v);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pthread_t *threads = calloc((size_t)v.threads, sizeof(*threads));
+    if (!threads)
+        die("verify: out of memory", ERROR_INVALID_ARGS);
+    int started = 0;
+    for (int t = 0; t < v.threads; t++) {
+        if (pthread_create(&threads[t], NULL, verify_worker, &v) != 0) {
+            perror("verify: pthread_create");
+            break;
+        }
+        started++;
+    }
+    if (started == 0)
+        verify_worker(&v);
+    for (int t = 0; t < started; t++)
+        pthread_join(threads[t], NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double secs = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    // Se informa en el orden de entrada, no en el que terminaron los threads
+    unsigned long events = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < v.count; i++) {
+        const verify_job_t *job = &v.jobs[i];
+        events += job->events;
+        if (job->status != VERIFY_OK)
+            failed++;
+        if (job->status == VERIFY_MISMATCH)
+            printf("%s: %s (player %u, %lu events)\n", job->path, status_names[job->status], job->bad_player, job->events);
+        else if (job->status != VERIFY_OK || !v.quiet)
+            printf("%s: %s (%lu events)\n", job->path, status_names[job->status], job->events);
+    }
+    printf("recordings: %zu  failed: %zu  threads: %d  time: %.3f s  games/sec: %.1f  events/sec: %.1f M\n",
+           v.count, failed, started ? started : 1, secs,
+           secs > 0 ? (double)v.count / secs : 0.0, secs > 0 ? (double)events / secs / 1e6 : 0.0);
+
+    for (size_t i = 0; i < v.count; i++)
+        free(v.jobs[i].path);
+    free(v.jobs);
+    free(threads);
+    return failed ? 1 : SUCCESS;
+}
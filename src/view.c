@@ -3,19 +3,21 @@
 // Vista ncurses a color con tablero fijo
 #define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
+#include <limits.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <ncurses.h>
 
 #include "common.h"
 #include "shm.h"
 #include "reader_sync.h"
-
-// Pares de color
-#define C_DEFAULT 1
-#define C_PLAYER_BASE 2
+#include "board_mirror.h"
+#include "view_draw.h"
+#include "stats.h"
 
 static void ui_init(void){
     if (getenv("TERM") == NULL) { 
@@ -51,101 +53,55 @@ static void ui_end(void){
 
 // Ya no coloreamos las recompensas: se imprimen en color por defecto
 
-static short color_for_player(unsigned id){
-    return C_PLAYER_BASE + (id % 9);
-}
-
-static void draw_header(const game_state_t *gs){
+static void draw_header(const game_state_t *gs, board_format_t format, size_t free_cells){
     attron(A_BOLD);
     mvprintw(0, 0, "ChompChamps %ux%u  players=%u  finished=%d",
              gs->board_width, gs->board_height, gs->num_players, gs->game_finished);
+    if (format == BOARD_FORMAT_COMPACT)
+        printw("  free=%zu", free_cells);
+    clrtoeol();
     attroff(A_BOLD);
 }
 
-static int draw_players(const game_state_t *gs, int start_row){
+static int draw_players(const game_state_t *gs, const player_t *extra, int start_row){
     mvprintw(start_row, 0, "Players:");
     int row = start_row + 1;
-    for (unsigned i = 0; i < gs->num_players; ++i){
-        const player_t *p = &gs->players[i];
+    // Con muchos jugadores la lista se corta para dejarle lugar al tablero
+    unsigned shown = gs->num_players;
+    unsigned max_rows = (unsigned)(getmaxy(stdscr) / 3);
+    if (shown > max_rows)
+        shown = max_rows > 0 ? max_rows - 1 : 0;
+    for (unsigned i = 0; i < shown; ++i){
+        const player_t *p = game_player_ro(gs, extra, i);
         short pc = color_for_player(i);
         attron(COLOR_PAIR(pc));
         mvprintw(row++, 0, "P%u %s  pos=(%u,%u)  score=%u  V=%u  I=%u",
                  i, p->is_blocked?" [BLOCKED]":"",
                  p->x, p->y, p->score, p->valid_moves, p->invalid_moves);
+        clrtoeol();
         attroff(COLOR_PAIR(pc));
     }
+    if (shown < gs->num_players) {
+        mvprintw(row++, 0, "... (%u more)", gs->num_players - shown);
+        clrtoeol();
+    }
     return row; // próxima fila libre
 }
 
-static void draw_board_centered(const game_state_t *gs, int reserve_top_rows){
-    int maxy, maxx; 
-    getmaxyx(stdscr, maxy, maxx);
-    const int cellw = 4; // ancho por celda: suficiente para "p[8]" o "%3d"
-
-    int bw = gs->board_width, bh = gs->board_height;
-    int draw_h = bh;
-    int draw_w = bw;
-    // Limitar por tamaño de terminal
-    if (draw_h > maxy - 2) 
-        draw_h = maxy - 2; // deja margen
-    if (draw_w * cellw > maxx - 2) 
-        draw_w = (maxx - 2) / cellw;
-    if (draw_h <= 0 || draw_w <= 0) 
+// Duerme hasta el próximo cuadro; si la vista se atrasó, el siguiente se cuenta desde ahora
+static void wait_next_frame(struct timespec *next, long frame_ns){
+    next->tv_nsec += frame_ns;
+    while (next->tv_nsec >= 1000000000L) {
+        next->tv_nsec -= 1000000000L;
+        next->tv_sec++;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec > next->tv_sec || (now.tv_sec == next->tv_sec && now.tv_nsec > next->tv_nsec)) {
+        *next = now;
         return;
-
-    // Centro ideal
-    int row0 = (maxy - draw_h) / 2;
-    int col0 = (maxx - draw_w * cellw) / 2;
-    // Evitar superponerse con header/lista de jugadores
-    if (row0 <= reserve_top_rows) row0 = reserve_top_rows + 1;
-    if (col0 < 0) col0 = 0;
-
-    // mvprintw(row0 - 1, col0, "Board (%dx%d shown of %dx%d):", draw_w, draw_h, bw, bh);
-
-    for (int y = 0; y < draw_h; ++y){
-        int sy = row0 + y; 
-        if (sy >= maxy) 
-            break;
-        for (int x = 0; x < draw_w; ++x){
-            int sx = col0 + x * cellw; 
-            if (sx + (cellw-1) >= maxx) 
-                break;
-
-            // ¿Hay un jugador parado en (x,y)?
-            int standing_pid = -1;
-            for (unsigned i = 0; i < gs->num_players; ++i){
-                const player_t *p = &gs->players[i];
-                if ((int)p->x == x && (int)p->y == y){ 
-                    standing_pid = (int)i; 
-                    break;
-                }
-            }
-
-            if (standing_pid >= 0){
-                short pc = color_for_player((unsigned)standing_pid);
-                attron(COLOR_PAIR(pc) | A_BOLD);
-                // p[id] con ancho 4 (ej: p[8] )
-                mvprintw(sy, sx, "p[%d]", standing_pid);
-                attroff(COLOR_PAIR(pc) | A_BOLD);
-                continue;
-            }
-
-            int v = gs->board[idx(x, y, bw)];
-            if (v > 0){
-                // Recompensas sin color especial
-                attron(COLOR_PAIR(C_DEFAULT));
-                mvprintw(sy, sx, "%3d ", v);
-                attroff(COLOR_PAIR(C_DEFAULT));
-            } else {
-                // 0 o negativo: se imprime el número tal cual, coloreado por jugador
-                unsigned pid = (unsigned)(-v);
-                short pc = color_for_player(pid);
-                attron(COLOR_PAIR(pc) | A_BOLD);
-                mvprintw(sy, sx, "%3d ", v);
-                attroff(COLOR_PAIR(pc) | A_BOLD);
-            }
-        }
     }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, next, NULL);
 }
 
 int main(int argc, char **argv){
@@ -156,38 +112,121 @@ int main(int argc, char **argv){
     int W = atoi(argv[1]), H = atoi(argv[2]);
 
     shm_adt state_h, sync_h;
-    if (shm_region_open_readonly(&state_h, SHM_STATE, game_state_size(W,H)) == -1) { 
+    if (shm_region_open_readonly(&state_h, shm_region_name(ENV_SHM_STATE, SHM_STATE), game_state_size(W, H, BOARD_FORMAT_INT)) == -1) { 
         perror("state open"); 
         return ERROR_SHM_ATTACH; 
     }
-    if (shm_region_open(&sync_h, SHM_SYNC, sizeof(game_sync_t)) == -1) { 
+    if (shm_region_open(&sync_h, shm_region_name(ENV_SHM_SYNC, SHM_SYNC), sizeof(game_sync_t)) == -1) { 
         perror("sync open");  
         return ERROR_SHM_ATTACH; 
     }
 
     game_state_t *gs=NULL; game_sync_t *sync=NULL;
-    if (game_state_map_readonly(state_h, (unsigned short)W, (unsigned short)H, &gs) == -1) {
-        perror("map state"); 
-        return ERROR_SHM_ATTACH; 
-    }
     if (game_sync_map(sync_h, &sync) == -1) { 
         perror("map sync"); 
         return ERROR_SHM_ATTACH; 
     }
+    board_format_t format = game_sync_board_format(sync_h);
+    if (game_state_map_readonly(state_h, (unsigned short)W, (unsigned short)H, format, game_sync_state_map_opts(sync_h), &gs) == -1) {
+        perror("map state"); 
+        return ERROR_SHM_ATTACH; 
+    }
+
+    // Se dibuja desde una copia local para soltar el estado lo antes posible: el encabezado
+    // y los jugadores se copian enteros, el tablero se mantiene con el log de cambios
+    read_protocol_t protocol = game_sync_read_protocol(sync_h);
+    size_t snap_size = sizeof(game_state_t);
+    game_state_t *snap = malloc(snap_size);
+    board_mirror_t mirror;
+    if (board_mirror_init(&mirror, W, H, format, game_state_delta_log(state_h, sync_h, (unsigned short)W, (unsigned short)H)) == -1) {
+        perror("board mirror alloc");
+        return ERROR_SHM_ATTACH;
+    }
+    frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    size_t free_cells = 0;
+    // Los jugadores a partir de MAX_PLAYERS están en otra tabla de la región: también se copian
+    const player_t *extra = game_state_extra_players(state_h, sync_h, (unsigned short)W, (unsigned short)H);
+    size_t extra_size = extra ? extra_player_count(gs->num_players) * sizeof(player_t) : 0;
+    player_t *snap_extra = extra_size ? malloc(extra_size) : NULL;
+    if (!snap || (extra_size && !snap_extra)) {
+        perror("snapshot alloc");
+        return ERROR_SHM_ATTACH;
+    }
+
+    // Cuadros dibujados y salteados en la región de estadísticas, solo si el master pasó su nombre
+    shm_adt stats_h = NULL;
+    game_stats_t *stats = NULL;
+    const char *stats_name = getenv(ENV_SHM_STATS);
+    if (stats_name && stats_name[0] == '/' && shm_region_open_existing(&stats_h, stats_name) == 0 &&
+        game_stats_map(stats_h, 0, &stats) == -1) {
+        game_stats_unmap_destroy(stats_h);
+        stats_h = NULL;
+        stats = NULL;
+    }
+
+    // Con view_fps > 0 el master no espera a la vista: se dibuja el último estado a lo sumo
+    // view_fps veces por segundo y los estados intermedios se saltean
+    unsigned fps = game_sync_view_fps(sync_h);
+    long frame_ns = fps ? 1000000000L / (long)fps : 0;
+    struct timespec next_frame;
+    clock_gettime(CLOCK_MONOTONIC, &next_frame);
+    unsigned last_gen = 0;
+    unsigned long frames = 0, skipped = 0;
 
     ui_init();
+    frame.win = stdscr;
     while (1){
-        sem_wait(&sync->view_ready);
-        reader_enter(sync);
-        int finished = gs->game_finished;
-
-        erase();
-        draw_header(gs);
-    int next_row = draw_players(gs, 2);
-    draw_board_centered(gs, next_row + 1);
-        refresh();
+        if (fps == 0) {
+            sem_wait(&sync->view_ready);
+        } else {
+            unsigned gen = __atomic_load_n(&sync->view_generation, __ATOMIC_ACQUIRE);
+            if (frames > 0 && gen == last_gen) {
+                wait_next_frame(&next_frame, frame_ns);
+                continue;
+            }
+            if (frames > 0) {
+                skipped += gen - last_gen - 1;
+                if (stats)
+                    stats_add(&stats->view_skipped, gen - last_gen - 1);
+            }
+            last_gen = gen;
+        }
+        unsigned t;
+        do {
+            t = snapshot_begin(sync, protocol);
+            memcpy(snap, gs, snap_size);
+            if (extra_size)
+                memcpy(snap_extra, extra, extra_size);
+            board_mirror_read(&mirror, gs);
+            // El bitmap de libres permite contarlas sin recorrer el tablero
+            if (format == BOARD_FORMAT_COMPACT)
+                free_cells = count_free_cells(free_bitmap(gs), free_bitmap_words(W, H));
+        } while (!snapshot_end(sync, protocol, t));
+        board_mirror_commit(&mirror);
+        int finished = snap->game_finished;
+        frames++;
+        if (stats)
+            stats_add(&stats->view_frames, 1);
 
-        reader_exit(sync);
+        draw_header(snap, format, free_cells);
+        if (fps) {
+            mvprintw(1, 0, "fps<=%u  frames=%lu  skipped=%lu", fps, frames, skipped);
+            clrtoeol();
+        }
+        int next_row = draw_players(snap, snap_extra, 2);
+        bool full = mirror.pending_full;
+        if (frame_layout(&frame, W, H, snap->num_players, next_row + 1, &full)) {
+            if (full) { // la pantalla se borró: hay que volver a escribir el texto
+                draw_header(snap, format, free_cells);
+                if (fps)
+                    mvprintw(1, 0, "fps<=%u  frames=%lu  skipped=%lu", fps, frames, skipped);
+                draw_players(snap, snap_extra, 2);
+            }
+            frame_index_players(&frame, snap, snap_extra);
+            draw_board_diff(&frame, &mirror, W, full);
+        }
+        refresh();
         
         if (finished) {
             int maxy = getmaxy(stdscr);
@@ -206,15 +245,22 @@ int main(int argc, char **argv){
             } while (ch != 'q' && ch != 'Q');
         }
         
-        sem_post(&sync->view_done);
+        if (fps == 0)
+            sem_post(&sync->view_done);
         if (finished)
             break;
-
-        
+        if (fps)
+            wait_next_frame(&next_frame, frame_ns);
     }
 
     ui_end();
 
+    free(snap);
+    free(snap_extra);
+    frame_free(&frame);
+    board_mirror_free(&mirror);
+    if (stats_h)
+        game_stats_unmap_destroy(stats_h);
     game_state_unmap_destroy(state_h);
     game_sync_unmap_destroy(sync_h);
     return SUCCESS;
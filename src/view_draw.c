@@ -0,0 +1,141 @@
+// This is a personal academic project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+#include <stdlib.h>
+#include <string.h>
+#include <ncurses.h>
+
+#include "common.h"
+#include "view_draw.h"
+
+void frame_free(frame_t *f){
+    free(f->drawn);
+    free(f->standing);
+    free(f->occupied);
+    free(f->prev_occupied);
+    WINDOW *win = f->win;
+    memset(f, 0, sizeof(*f));
+    f->win = win;
+}
+
+bool frame_layout(frame_t *f, int bw, int bh, unsigned num_players, int reserve_top_rows, bool *full){
+    int maxy, maxx;
+    getmaxyx(f->win, maxy, maxx);
+    int draw_h = bh, draw_w = bw;
+    // Limitar por tamaño de terminal
+    if (draw_h > maxy - 2)
+        draw_h = maxy - 2; // deja margen
+    if (draw_w * CELL_W > maxx - 2)
+        draw_w = (maxx - 2) / CELL_W;
+    // Centro ideal, sin superponerse con header/lista de jugadores
+    int row0 = (maxy - draw_h) / 2;
+    int col0 = (maxx - draw_w * CELL_W) / 2;
+    if (row0 <= reserve_top_rows) row0 = reserve_top_rows + 1;
+    if (col0 < 0) col0 = 0;
+    if (draw_h > maxy - row0)
+        draw_h = maxy - row0;
+    if (draw_h <= 0 || draw_w <= 0)
+        return false;
+
+    if (f->drawn && f->row0 == row0 && f->col0 == col0 && f->draw_w == draw_w && f->draw_h == draw_h)
+        return true;
+
+    frame_free(f);
+    size_t cells = (size_t)draw_w * draw_h;
+    size_t max_occupied = num_players < cells ? num_players : cells;
+    f->drawn = malloc(cells * sizeof(int));
+    f->standing = malloc(cells * sizeof(int));
+    f->occupied = malloc((max_occupied + 1) * sizeof(int));
+    f->prev_occupied = malloc((max_occupied + 1) * sizeof(int));
+    if (!f->drawn || !f->standing || !f->occupied || !f->prev_occupied) {
+        frame_free(f);
+        return false;
+    }
+    for (size_t i = 0; i < cells; i++) {
+        f->drawn[i] = NOT_DRAWN;
+        f->standing[i] = -1;
+    }
+    f->row0 = row0;
+    f->col0 = col0;
+    f->draw_w = draw_w;
+    f->draw_h = draw_h;
+    werase(f->win);
+    *full = true;
+    return true;
+}
+
+void frame_index_players(frame_t *f, const game_state_t *gs, const player_t *extra){
+    // Se limpian las celdas del cuadro anterior y se marcan las actuales
+    int *tmp = f->prev_occupied;
+    f->prev_occupied = f->occupied;
+    f->prev_occupied_count = f->occupied_count;
+    f->occupied = tmp;
+    for (unsigned k = 0; k < f->prev_occupied_count; k++)
+        f->standing[f->prev_occupied[k]] = -1;
+    f->occupied_count = 0;
+    for (unsigned i = 0; i < gs->num_players; ++i){
+        const player_t *p = game_player_ro(gs, extra, i);
+        if (p->x >= f->draw_w || p->y >= f->draw_h)
+            continue;
+        int v = p->y * f->draw_w + p->x;
+        if (f->standing[v] < 0) {
+            f->standing[v] = (int)i;
+            f->occupied[f->occupied_count++] = v;
+        }
+    }
+}
+
+static void draw_cell(const frame_t *f, int v, int key){
+    int sy = f->row0 + v / f->draw_w;
+    int sx = f->col0 + (v % f->draw_w) * CELL_W;
+    if (key <= STANDING_KEY(0)){
+        int standing_pid = STANDING_KEY(0) - key;
+        short pc = color_for_player((unsigned)standing_pid);
+        wattron(f->win, COLOR_PAIR(pc) | A_BOLD);
+        // p[id] con ancho 4 (ej: p[8] ); desde el jugador 10 no entran los corchetes
+        if (standing_pid < 10)
+            mvwprintw(f->win, sy, sx, "p[%d]", standing_pid);
+        else
+            mvwprintw(f->win, sy, sx, "p%-3d", standing_pid);
+        wattroff(f->win, COLOR_PAIR(pc) | A_BOLD);
+    } else if (key > 0){
+        // Recompensas sin color especial
+        wattron(f->win, COLOR_PAIR(C_DEFAULT));
+        mvwprintw(f->win, sy, sx, "%3d ", key);
+        wattroff(f->win, COLOR_PAIR(C_DEFAULT));
+    } else {
+        // 0 o negativo: se imprime el número tal cual, coloreado por jugador
+        short pc = color_for_player((unsigned)(-key));
+        wattron(f->win, COLOR_PAIR(pc) | A_BOLD);
+        mvwprintw(f->win, sy, sx, "%3d ", key);
+        wattroff(f->win, COLOR_PAIR(pc) | A_BOLD);
+    }
+}
+
+// Redibuja la celda visible v solo si cambió respecto de lo que hay en pantalla
+static void refresh_cell(frame_t *f, const int *board, int bw, int v){
+    int pid = f->standing[v];
+    int key = pid >= 0 ? STANDING_KEY(pid) : board[idx(v % f->draw_w, v / f->draw_w, bw)];
+    if (key != f->drawn[v]) {
+        draw_cell(f, v, key);
+        f->drawn[v] = key;
+    }
+}
+
+void draw_board_diff(frame_t *f, const board_mirror_t *mirror, int bw, bool full){
+    if (full) {
+        for (int v = 0; v < f->draw_w * f->draw_h; v++)
+            refresh_cell(f, mirror->board, bw, v);
+        return;
+    }
+    for (size_t k = 0; k < mirror->pending_count; k++) {
+        unsigned cell = mirror->pending[k].cell;
+        int x = (int)(cell % (unsigned)bw), y = (int)(cell / (unsigned)bw);
+        if (x < f->draw_w && y < f->draw_h)
+            refresh_cell(f, mirror->board, bw, y * f->draw_w + x);
+    }
+    for (unsigned k = 0; k < f->prev_occupied_count; k++)
+        refresh_cell(f, mirror->board, bw, f->prev_occupied[k]);
+    for (unsigned k = 0; k < f->occupied_count; k++)
+        refresh_cell(f, mirror->board, bw, f->occupied[k]);
+}
+